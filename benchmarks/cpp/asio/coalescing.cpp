@@ -0,0 +1,129 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <deque>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <aedis/coalescing_policy.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Sweeps the request rate and compares the number of writes and the
+ * latency with and without coalescing_policy. The connection is
+ * simulated as in the writer: requests are written when no response
+ * is outstanding, each write being answered after the round trip time
+ * plus a cost per command. Arrivals are Poisson, so the simulation is
+ * reproducible and needs no server.
+ *
+ *    $ ./coalescing [rtt_us] [max_delay_us] [requests]
+ */
+
+using duration = std::chrono::nanoseconds;
+using time_point = std::chrono::steady_clock::time_point;
+
+struct result {
+   std::size_t writes = 0;
+   double mean_us = 0;
+   double p99_us = 0;
+};
+
+result
+simulate(
+   std::vector<time_point> const& arrivals,
+   duration rtt,
+   std::chrono::microseconds max_delay)
+{
+   auto const per_command = duration{200};
+   auto const request_size = 40U;
+   aedis::coalescing_policy policy{max_delay};
+
+   std::deque<time_point> queue;
+   std::vector<double> latencies;
+   latencies.reserve(arrivals.size());
+
+   result ret;
+   std::size_t next = 0;
+   time_point now;
+
+   auto const arrive = [&]() {
+      now = arrivals[next++];
+      queue.push_back(now);
+      if (policy.enabled())
+         policy.on_arrival(now);
+   };
+
+   while (latencies.size() < arrivals.size()) {
+      if (queue.empty())
+         arrive();
+
+      // The writer waits for more requests while the policy says so.
+      auto const deadline = now + policy.window(queue.size() * request_size, queue.size());
+      while (next < arrivals.size() && arrivals[next] <= deadline && !policy.full(queue.size() * request_size, queue.size()))
+         arrive();
+
+      if (!policy.full(queue.size() * request_size, queue.size()))
+         now = (std::max)(now, deadline);
+
+      // Writes the batch, requests arriving meanwhile are queued.
+      ++ret.writes;
+      auto const written = queue.size();
+      auto const write_time = now;
+      auto const done = now + rtt + static_cast<duration::rep>(written) * per_command;
+      while (next < arrivals.size() && arrivals[next] <= done)
+         arrive();
+
+      for (std::size_t i = 0; i < written; ++i) {
+         latencies.push_back(std::chrono::duration<double, std::micro>(done - queue.front()).count());
+         queue.pop_front();
+      }
+
+      policy.on_round_trip(done - write_time);
+      now = done;
+   }
+
+   std::sort(std::begin(latencies), std::end(latencies));
+   double sum = 0;
+   for (auto l: latencies)
+      sum += l;
+
+   ret.mean_us = sum / latencies.size();
+   ret.p99_us = latencies[latencies.size() * 99 / 100];
+   return ret;
+}
+
+int main(int argc, char* argv[])
+{
+   auto const rtt = std::chrono::microseconds{argc > 1 ? std::atol(argv[1]) : 200};
+   auto const max_delay = std::chrono::microseconds{argc > 2 ? std::atol(argv[2]) : 100};
+   auto const n = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000UL;
+
+   std::printf("rtt %ld us, max delay %ld us\n\n", static_cast<long>(rtt.count()), static_cast<long>(max_delay.count()));
+   std::printf("%10s | %22s | %22s | %22s\n", "", "writes per 1k requests", "mean latency (us)", "p99 latency (us)");
+   std::printf("%10s | %10s %11s | %10s %11s | %10s %11s\n", "req/s", "off", "on", "off", "on", "off", "on");
+
+   for (double rate: {1e3, 5e3, 1e4, 2e4, 5e4, 1e5, 2e5, 5e5, 1e6}) {
+      std::mt19937_64 gen{42};
+      std::exponential_distribution<double> gap{rate};
+
+      std::vector<time_point> arrivals(n);
+      time_point t;
+      for (auto& a: arrivals) {
+         t += duration{static_cast<duration::rep>(gap(gen) * 1e9)};
+         a = t;
+      }
+
+      auto const off = simulate(arrivals, rtt, std::chrono::microseconds{0});
+      auto const on = simulate(arrivals, rtt, max_delay);
+      std::printf("%10.0f | %10.1f %11.1f | %10.1f %11.1f | %10.1f %11.1f\n", rate,
+         1000.0 * off.writes / n, 1000.0 * on.writes / n,
+         off.mean_us, on.mean_us, off.p99_us, on.p99_us);
+   }
+}
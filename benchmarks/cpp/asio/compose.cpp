@@ -0,0 +1,106 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <aedis/resp3/request.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Measures the time it takes to compose requests of a few typical
+ * shapes, once on a request that is cleared and reused and once on a
+ * new request every time.
+ *
+ *    $ ./compose [requests]
+ */
+
+using clock_type = std::chrono::steady_clock;
+using aedis::resp3::request;
+using aedis::resp3::prepared_command;
+
+// Keeps the compiler from optimizing the request away.
+std::size_t sink = 0;
+
+template <class Push>
+void bench(char const* name, std::size_t n, Push push)
+{
+   request req;
+   auto const t0 = clock_type::now();
+   for (std::size_t i = 0; i < n; ++i) {
+      req.clear();
+      push(req, i);
+      sink += req.payload().size();
+   }
+   auto const t1 = clock_type::now();
+
+   for (std::size_t i = 0; i < n; ++i) {
+      request fresh;
+      push(fresh, i);
+      sink += fresh.payload().size();
+   }
+   auto const t2 = clock_type::now();
+
+   auto const ns = [n](auto d) { return std::chrono::duration<double, std::nano>(d).count() / n; };
+   std::printf("%-22s %10.1f %10.1f\n", name, ns(t1 - t0), ns(t2 - t1));
+}
+
+int main(int argc, char* argv[])
+{
+   auto const n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000UL;
+
+   std::string const key = "stats:user:1234567";
+   std::string const value(1024, 'v');
+   std::map<std::string, std::string> map;
+   for (int i = 0; i < 10; ++i)
+      map.emplace("field" + std::to_string(i), "value" + std::to_string(i));
+
+   std::printf("%-22s %10s %10s\n", "ns per request", "reused", "new");
+
+   bench("GET key", n, [&](request& req, std::size_t) {
+      req.push("GET", key);
+   });
+
+   bench("HINCRBY key field n", n, [&](request& req, std::size_t i) {
+      req.push("HINCRBY", key, "field", i);
+   });
+
+   bench("HINCRBY typed", n, [&](request& req, std::size_t i) {
+      req.hincrby(key, "field", i);
+   });
+
+   prepared_command const hincrby{"HINCRBY stats:user:{} field {}"};
+   bench("HINCRBY prepared", n, [&](request& req, std::size_t i) {
+      req.push(hincrby, 1234567, i);
+   });
+
+   bench("SET key 1KiB EX 60", n, [&](request& req, std::size_t) {
+      req.push("SET", key, value, "EX", 60);
+   });
+
+   bench("SET typed", n, [&](request& req, std::size_t) {
+      req.set(key, value, "EX", 60);
+   });
+
+   prepared_command const set{"SET {} {} EX 60"};
+   bench("SET prepared", n, [&](request& req, std::size_t) {
+      req.push(set, key, value);
+   });
+
+   bench("HSET key 10 fields", n, [&](request& req, std::size_t) {
+      req.push_range("HSET", key, map);
+   });
+
+   bench("10x INCR key", n, [&](request& req, std::size_t) {
+      for (int j = 0; j < 10; ++j)
+         req.push("INCR", key);
+   });
+
+   return sink == 0;
+}
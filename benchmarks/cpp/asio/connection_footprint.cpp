@@ -0,0 +1,134 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <new>
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <boost/asio.hpp>
+#include <aedis.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Reports the memory used by idle connections: sizeof(connection)
+ * and the heap bytes per connection, right after construction and,
+ * when "connect" is passed, after all connections are established
+ * and idle. Passing "slim" sets max_idle_buffer_size to zero.
+ *
+ *    $ ./connection_footprint 1000
+ *    $ ./connection_footprint 1000 connect
+ *    $ ./connection_footprint 1000 connect slim
+ */
+
+namespace net = boost::asio;
+using aedis::adapt;
+using connection = aedis::connection<>;
+
+namespace {
+
+// Bytes currently allocated with operator new.
+std::size_t live_bytes = 0;
+
+// Keeps the alignment of max_align_t.
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(std::size_t n)
+{
+   auto* p = static_cast<char*>(std::malloc(n + header_size));
+   if (p == nullptr)
+      throw std::bad_alloc{};
+
+   *reinterpret_cast<std::size_t*>(p) = n;
+   live_bytes += n;
+   return p + header_size;
+}
+
+void operator delete(void* p) noexcept
+{
+   if (p == nullptr)
+      return;
+
+   auto* q = static_cast<char*>(p) - header_size;
+   live_bytes -= *reinterpret_cast<std::size_t*>(q);
+   std::free(q);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   operator delete(p);
+}
+
+void receive_events(std::shared_ptr<connection> db, std::size_t& hellos, std::function<void()> const& on_hello)
+{
+   db->async_receive_event(adapt(), [db, &hellos, &on_hello](auto ec, auto ev) {
+      if (ec)
+         return;
+
+      if (ev == connection::event::hello) {
+         ++hellos;
+         on_hello();
+      }
+
+      receive_events(db, hellos, on_hello);
+   });
+}
+
+int main(int argc, char* argv[])
+{
+   std::size_t const n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+   bool const connect = argc > 2 && std::string{argv[2]} == "connect";
+   bool const slim = argc > 3 && std::string{argv[3]} == "slim";
+
+   net::io_context ioc{1};
+
+   connection::config cfg;
+   cfg.enable_events = true;
+   if (slim)
+      cfg.max_idle_buffer_size = 0;
+
+   std::vector<std::shared_ptr<connection>> conns;
+   conns.reserve(n);
+
+   auto const before = live_bytes;
+   for (std::size_t i = 0; i < n; ++i)
+      conns.push_back(std::make_shared<connection>(ioc, cfg));
+
+   std::printf("sizeof(connection): %zu bytes\n", sizeof(connection));
+   std::printf("Constructed: %zu heap bytes per connection (including the connection)\n", (live_bytes - before) / n);
+
+   if (!connect)
+      return 0;
+
+   std::size_t hellos = 0;
+   std::function<void()> on_hello = [&]() {
+      if (hellos != n)
+         return;
+
+      // Lets the health checks settle before measuring.
+      auto timer = std::make_shared<net::steady_timer>(ioc, std::chrono::seconds{3});
+      timer->async_wait([&, timer](auto) {
+         std::printf("Connected and idle: %zu heap bytes per connection (including the connection)\n", (live_bytes - before) / n);
+         for (auto& db: conns) {
+            db->cancel_run();
+            db->cancel_event_receiver();
+         }
+      });
+   };
+
+   for (auto& db: conns) {
+      receive_events(db, hellos, on_hello);
+      db->async_run([](auto) {});
+   }
+
+   ioc.run();
+}
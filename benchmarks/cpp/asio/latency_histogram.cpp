@@ -0,0 +1,89 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Like every program using the histograms, this is compiled with
+// -DAEDIS_ENABLE_LATENCY_HISTOGRAMS instead of defining it here, see
+// aedis::latency_histograms.
+#if !defined(AEDIS_ENABLE_LATENCY_HISTOGRAMS)
+#error "Compile with -DAEDIS_ENABLE_LATENCY_HISTOGRAMS."
+#endif
+
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <aedis/latency_histogram.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Measures the overhead added to every request by the latency
+ * instrumentation, i.e. what AEDIS_ENABLE_LATENCY_HISTOGRAMS costs.
+ * The hooks are called in the same order as the connection calls
+ * them.
+ *
+ *    $ ./latency_histogram [requests]
+ */
+
+using clock_type = std::chrono::steady_clock;
+
+struct req_info {
+   bool written = false;
+   aedis::detail::latency_marks marks;
+};
+
+double to_ns(clock_type::duration d, std::size_t n)
+{
+   return std::chrono::duration<double, std::nano>(d).count() / n;
+}
+
+void bench_record(std::size_t n)
+{
+   aedis::latency_histogram h;
+
+   auto const t0 = clock_type::now();
+   for (std::size_t i = 0; i < n; ++i)
+      h.record(std::chrono::nanoseconds{static_cast<long>(i * 7919 % 10000000)});
+   auto const t1 = clock_type::now();
+
+   std::printf("record:      %.1f ns per value, p99 %lld ns\n", to_ns(t1 - t0, n),
+      static_cast<long long>(h.percentile(99).count()));
+}
+
+void bench_request(std::size_t n)
+{
+   aedis::detail::latency_recorder rec;
+   std::vector<std::shared_ptr<req_info>> reqs{std::make_shared<req_info>()};
+   auto& info = *reqs.front();
+
+   auto const t0 = clock_type::now();
+   for (std::size_t i = 0; i < n; ++i) {
+      rec.on_enqueue(info.marks);
+      info.written = true;
+      rec.on_write_start(info.marks);
+      rec.on_write_complete(reqs);
+      rec.on_first_byte(info.marks);
+      rec.on_parsed(info.marks);
+      info.written = false;
+   }
+   auto const t1 = clock_type::now();
+
+   auto const& total = rec.histograms()[aedis::latency_phase::total];
+   std::printf("request:     %.1f ns per request\n", to_ns(t1 - t0, n));
+   std::printf("total phase: p50 %lld ns, p99 %lld ns, count %llu\n",
+      static_cast<long long>(total.percentile(50).count()),
+      static_cast<long long>(total.percentile(99).count()),
+      static_cast<unsigned long long>(total.count()));
+}
+
+int main(int argc, char* argv[])
+{
+   std::size_t const n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+   bench_record(n);
+   bench_request(n);
+}
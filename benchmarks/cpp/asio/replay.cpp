@@ -0,0 +1,156 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <boost/asio.hpp>
+#include <aedis.hpp>
+#include <aedis/recording_stream.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Replays the traffic received by a connection through the RESP3
+ * parser and adapters, with no network involved. Recordings are made
+ * with aedis::recording_stream, see its documentation.
+ *
+ *    $ ./replay capture.bin [ignore|nodes] [iterations]
+ *
+ * where ignore discards the responses and nodes stores them in a
+ * std::vector<node<std::string>>. Recorded traffic is a reproducible
+ * input for throughput measurements and regression tests of the
+ * parser.
+ */
+
+namespace net = boost::asio;
+namespace resp3 = aedis::resp3;
+using clock_type = std::chrono::steady_clock;
+
+// A synchronous stream that reads from memory.
+class memory_stream {
+public:
+   explicit memory_stream(std::string const& data) : data_{data} {}
+
+   template <class MutableBufferSequence>
+   std::size_t read_some(MutableBufferSequence const& buffers, boost::system::error_code& ec)
+   {
+      if (pos_ == data_.size()) {
+         ec = net::error::eof;
+         return 0;
+      }
+
+      auto const n = net::buffer_copy(buffers, net::buffer(data_.data() + pos_, data_.size() - pos_));
+      pos_ += n;
+      ec = {};
+      return n;
+   }
+
+   template <class MutableBufferSequence>
+   std::size_t read_some(MutableBufferSequence const& buffers)
+   {
+      boost::system::error_code ec;
+      auto const n = read_some(buffers, ec);
+      if (ec)
+         throw boost::system::system_error{ec};
+      return n;
+   }
+
+   bool at_end() const noexcept { return pos_ == data_.size(); }
+
+private:
+   std::string const& data_;
+   std::size_t pos_ = 0;
+};
+
+// The traffic received on each connection of the recording.
+std::vector<std::string> load(std::string const& path)
+{
+   aedis::traffic_reader reader{path};
+   std::vector<std::string> ret;
+
+   aedis::traffic_record rec;
+   while (reader.next(rec)) {
+      switch (rec.direction) {
+         case aedis::traffic_direction::connection: ret.emplace_back(); break;
+         case aedis::traffic_direction::received:
+         {
+            if (ret.empty())
+               ret.emplace_back();
+            ret.back() += rec.data;
+         } break;
+         default:;
+      }
+   }
+
+   return ret;
+}
+
+// Returns the number of messages parsed.
+template <class Adapter>
+std::size_t replay(std::string const& data, Adapter adapter)
+{
+   std::size_t msgs = 0;
+   std::string buffer;
+   memory_stream stream{data};
+
+   while (!stream.at_end() || !buffer.empty()) {
+      boost::system::error_code ec;
+      resp3::read(stream, net::dynamic_buffer(buffer), adapter, ec);
+      if (ec) {
+         // A connection may end in the middle of a message.
+         if (ec != net::error::eof)
+            std::cerr << "Error: " << ec.message() << std::endl;
+         break;
+      }
+
+      ++msgs;
+   }
+
+   return msgs;
+}
+
+int main(int argc, char* argv[])
+{
+   if (argc < 2) {
+      std::cerr << "Usage: " << argv[0] << " capture.bin [ignore|nodes] [iterations]" << std::endl;
+      return 1;
+   }
+
+   try {
+      std::string const adapter = argc > 2 ? argv[2] : "ignore";
+      auto const iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 100UL;
+      auto const conns = load(argv[1]);
+
+      std::size_t bytes = 0;
+      for (auto const& c: conns)
+         bytes += c.size();
+
+      std::size_t msgs = 0;
+      auto const t0 = clock_type::now();
+      for (unsigned long i = 0; i < iterations; ++i) {
+         for (auto const& c: conns) {
+            if (adapter == "nodes") {
+               std::vector<resp3::node<std::string>> resp;
+               msgs += replay(c, aedis::adapter::adapt(resp));
+            } else {
+               msgs += replay(c, aedis::adapter::adapt());
+            }
+         }
+      }
+      auto const t1 = clock_type::now();
+
+      auto const s = std::chrono::duration<double>(t1 - t0).count();
+      std::printf("%zu connections, %zu bytes, %zu messages per iteration\n", conns.size(), bytes, msgs / iterations);
+      std::printf("%.1f MB/s, %.0f messages/s\n", bytes * iterations / s / 1e6, msgs / s);
+   } catch (std::exception const& e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+   }
+}
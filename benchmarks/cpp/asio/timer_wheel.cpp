@@ -0,0 +1,87 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <boost/asio.hpp>
+#include <aedis/timer_wheel.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+/* Compares the cost of rearming one health check timer per
+ * connection, as done by the connection without a timer wheel, to
+ * the cost of rearming a shared aedis::timer_wheel.
+ *
+ * Every round rearms the timers of all connections, which is what
+ * happens every ping_interval.
+ *
+ *    $ ./timer_wheel [connections] [rounds]
+ */
+
+namespace net = boost::asio;
+using clock_type = std::chrono::steady_clock;
+
+double to_ns(clock_type::duration d, std::size_t n)
+{
+   return std::chrono::duration<double, std::nano>(d).count() / n;
+}
+
+void bench_steady_timer(std::size_t conns, std::size_t rounds)
+{
+   net::io_context ioc;
+   std::vector<std::unique_ptr<net::steady_timer>> timers;
+   for (std::size_t i = 0; i < conns; ++i)
+      timers.push_back(std::make_unique<net::steady_timer>(ioc));
+
+   auto const t0 = clock_type::now();
+   for (std::size_t r = 0; r < rounds; ++r) {
+      for (std::size_t i = 0; i < conns; ++i) {
+         // Spread the expiries as connections start at different times.
+         timers[i]->expires_after(std::chrono::milliseconds{1000 + i % 1000});
+         timers[i]->async_wait([](auto) {});
+      }
+      ioc.poll();
+   }
+   auto const t1 = clock_type::now();
+
+   for (auto& t: timers)
+      t->cancel();
+   ioc.run();
+
+   std::printf("steady_timer: %zu connections, %.1f ns per rearm\n", conns, to_ns(t1 - t0, conns * rounds));
+}
+
+void bench_timer_wheel(std::size_t conns, std::size_t rounds)
+{
+   net::io_context ioc;
+   auto wheel = std::make_shared<aedis::timer_wheel>(ioc.get_executor());
+   std::vector<std::unique_ptr<aedis::timer_wheel::entry>> entries;
+   for (std::size_t i = 0; i < conns; ++i)
+      entries.push_back(std::make_unique<aedis::timer_wheel::entry>([](void*) {}, nullptr));
+
+   auto const t0 = clock_type::now();
+   for (std::size_t r = 0; r < rounds; ++r) {
+      for (std::size_t i = 0; i < conns; ++i)
+         wheel->arm(*entries[i], std::chrono::milliseconds{1000 + i % 1000});
+      ioc.poll();
+   }
+   auto const t1 = clock_type::now();
+
+   std::printf("timer_wheel:  %zu connections, %.1f ns per rearm\n", conns, to_ns(t1 - t0, conns * rounds));
+}
+
+int main(int argc, char* argv[])
+{
+   std::size_t const conns = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+   std::size_t const rounds = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+   bench_steady_timer(conns, rounds);
+   bench_timer_wheel(conns, rounds);
+}
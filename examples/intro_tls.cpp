@@ -0,0 +1,80 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <tuple>
+#include <string>
+#include <iostream>
+#include <boost/asio.hpp>
+#include <aedis.hpp>
+#include <aedis/ssl/connection.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+namespace net = boost::asio;
+
+using aedis::adapt;
+using aedis::resp3::request;
+using connection = aedis::ssl::connection<>;
+
+/* Connects twice to a Redis instance over TLS, the second connection
+ * resumes the TLS session of the first.
+ *
+ * A local test server with a self-signed certificate can be started
+ * with
+ *
+ *    $ openssl req -x509 -newkey rsa:2048 -nodes -days 365 \
+ *         -subj "/CN=localhost" -keyout redis.key -out redis.crt
+ *    $ redis-server --port 0 --tls-port 6380 --tls-cert-file redis.crt \
+ *         --tls-key-file redis.key --tls-ca-cert-file redis.crt \
+ *         --tls-auth-clients no
+ *
+ * and this example run with
+ *
+ *    $ ./intro_tls redis.crt
+ */
+
+int main(int argc, char* argv[])
+{
+   try {
+      net::io_context ioc;
+
+      net::ssl::context ctx{net::ssl::context::tls_client};
+      if (argc == 2) {
+         ctx.load_verify_file(argv[1]);
+         ctx.set_verify_mode(net::ssl::verify_peer);
+      }
+
+      connection::config cfg;
+      cfg.host = "localhost";
+      cfg.port = "6380";
+
+      connection db{ioc, ctx, cfg};
+
+      request req;
+      req.push("PING");
+      req.push("QUIT");
+
+      std::tuple<std::string, aedis::ignore> resp;
+
+      auto const print = [&](auto ec, auto) {
+         std::cout
+            << ec.message() << ", "
+            << std::get<0>(resp) << ", session reused: "
+            << std::boolalpha << !!SSL_session_reused(db.next_layer().native_handle())
+            << std::endl;
+      };
+
+      db.async_run(req, adapt(resp), [&](auto ec, auto n) {
+         print(ec, n);
+         db.async_run(req, adapt(resp), print);
+      });
+
+      ioc.run();
+   } catch (std::exception const& e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+   }
+}
@@ -18,7 +18,6 @@
 
 namespace net = boost::asio;
 using aedis::adapt;
-using aedis::resp3::request;
 using node_type = aedis::resp3::node<std::string>;
 using tcp_socket = net::use_awaitable_t<>::as_default_on_t<net::ip::tcp::socket>;
 using connection = aedis::connection<tcp_socket>;
@@ -41,9 +40,6 @@ using connection = aedis::connection<tcp_socket>;
 
 net::awaitable<void> receiver(std::shared_ptr<connection> db)
 {
-   request req;
-   req.push("SUBSCRIBE", "channel");
-
    for (std::vector<node_type> resp;;) {
       auto const ev = co_await db->async_receive_event(aedis::adapt(resp));
 
@@ -55,12 +51,6 @@ net::awaitable<void> receiver(std::shared_ptr<connection> db)
          resp.clear();
          break;
 
-         case connection::event::hello:
-         // Subscribes to the channels when a new connection is
-         // stablished.
-         co_await db->async_exec(req);
-         break;
-
          default:;
       }
    }
@@ -75,6 +65,10 @@ int main()
       db->get_config().enable_events = true;
       db->get_config().enable_reconnect = true;
 
+      // Subscribes to the channels together with HELLO on every new
+      // connection.
+      db->get_config().init.push("SUBSCRIBE", "channel");
+
       net::co_spawn(ioc, receiver(db), net::detached);
       db->async_run(net::detached);
       net::signal_set signals(ioc, SIGINT, SIGTERM);
@@ -0,0 +1,176 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <map>
+#include <tuple>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <iostream>
+#include <boost/asio.hpp>
+#include <aedis.hpp>
+
+// Include this in no more than one .cpp file.
+#include <aedis/src.hpp>
+
+namespace net = boost::asio;
+
+using aedis::adapt;
+using aedis::resp3::request;
+using aedis::resp3::request_view;
+using clock_type = std::chrono::steady_clock;
+
+/* A minimal span API in the style of OpenTelemetry, a real
+ * application would forward the calls below to its tracing library
+ * instead, with the span of the incoming request as parent.
+ */
+class span {
+public:
+   explicit span(std::string name)
+   : name_{std::move(name)}
+   , start_{clock_type::now()}
+   { }
+
+   void add_event(char const* name)
+      { events_.emplace_back(name, clock_type::now()); }
+
+   void set_attribute(char const* key, std::string value)
+      { attrs_ += std::string{" "} + key + "=" + value; }
+
+   void end()
+   {
+      auto const us = [this](clock_type::time_point t)
+         { return std::chrono::duration_cast<std::chrono::microseconds>(t - start_).count(); };
+
+      std::cout << "span " << name_ << attrs_;
+      for (auto const& e: events_)
+         std::cout << " " << e.first << "@" << us(e.second) << "us";
+      std::cout << " end@" << us(clock_type::now()) << "us" << std::endl;
+   }
+
+private:
+   std::string name_;
+   clock_type::time_point start_;
+   std::vector<std::pair<char const*, clock_type::time_point>> events_;
+   std::string attrs_;
+};
+
+/* Bridges the connection tracer to spans: one span per request from
+ * async_exec to its completion, with the write and the response as
+ * events, and one span per connection attempt.
+ */
+class span_tracer {
+public:
+   void on_exec(request_view const& req) noexcept
+   {
+      auto s = std::make_unique<span>("redis.exec");
+      s->set_attribute("commands", std::to_string(req.size()));
+      spans_[req.id()] = std::move(s);
+   }
+
+   void on_write_begin(request_view const& req, std::size_t size) noexcept
+   {
+      if (auto* s = find(req)) {
+         s->add_event("write");
+         s->set_attribute("request_bytes", std::to_string(size));
+      }
+   }
+
+   void on_write_end(boost::system::error_code, std::size_t) noexcept {}
+
+   void on_response_begin(request_view const& req) noexcept
+   {
+      if (auto* s = find(req))
+         s->add_event("response");
+   }
+
+   void on_response_end(request_view const& req, boost::system::error_code ec, std::size_t size) noexcept
+   {
+      auto iter = spans_.find(req.id());
+      if (iter == std::end(spans_))
+         return;
+
+      iter->second->set_attribute("response_bytes", std::to_string(size));
+      if (ec)
+         iter->second->set_attribute("error", ec.message());
+      iter->second->end();
+      spans_.erase(iter);
+   }
+
+   void on_resolve(boost::system::error_code ec) noexcept
+   {
+      conn_span_ = std::make_unique<span>("redis.connect");
+      step("resolve", ec);
+   }
+
+   void on_connect(boost::system::error_code ec) noexcept { step("connect", ec); }
+   void on_handshake(boost::system::error_code ec) noexcept { step("handshake", ec); }
+
+   void on_hello(boost::system::error_code ec) noexcept
+   {
+      step("hello", ec);
+      if (conn_span_) {
+         conn_span_->end();
+         conn_span_ = nullptr;
+      }
+   }
+
+   void on_reconnect(std::size_t attempt, std::chrono::milliseconds delay) noexcept
+   {
+      std::cout << "reconnect attempt " << attempt << " in " << delay.count() << "ms" << std::endl;
+   }
+
+private:
+   span* find(request_view const& req)
+   {
+      auto iter = spans_.find(req.id());
+      return iter == std::end(spans_) ? nullptr : iter->second.get();
+   }
+
+   void step(char const* name, boost::system::error_code ec)
+   {
+      if (!conn_span_)
+         return;
+
+      conn_span_->add_event(name);
+      if (ec) {
+         conn_span_->set_attribute("error", ec.message());
+         conn_span_->end();
+         conn_span_ = nullptr;
+      }
+   }
+
+   std::map<void const*, std::unique_ptr<span>> spans_;
+   std::unique_ptr<span> conn_span_;
+};
+
+using connection = aedis::connection<net::ip::tcp::socket, span_tracer>;
+
+int main()
+{
+   net::io_context ioc;
+   connection db{ioc};
+
+   request req1;
+   req1.push("PING");
+
+   request req2;
+   req2.push("INCR", "tracing-counter");
+   req2.push("QUIT");
+
+   std::tuple<std::string> resp1;
+   db.async_exec(req1, adapt(resp1), [](auto ec, auto) {
+      std::cout << "PING: " << ec.message() << std::endl;
+   });
+
+   std::tuple<int, aedis::ignore> resp2;
+   db.async_run(req2, adapt(resp2), [](auto ec, auto) {
+      std::cout << "INCR: " << ec.message() << std::endl;
+   });
+
+   ioc.run();
+}
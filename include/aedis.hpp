@@ -9,8 +9,22 @@
 
 #include <aedis/error.hpp>
 #include <aedis/adapt.hpp>
+#include <aedis/coalescing_policy.hpp>
 #include <aedis/connection.hpp>
+#include <aedis/diagnostics.hpp>
+#include <aedis/exec_result.hpp>
+#include <aedis/hash_slot.hpp>
+#include <aedis/latency_histogram.hpp>
+#include <aedis/reconnect_policy.hpp>
+#include <aedis/recording_stream.hpp>
+#include <aedis/resolve_cache.hpp>
+#include <aedis/stats.hpp>
+#include <aedis/sync_connection.hpp>
+#include <aedis/timer_wheel.hpp>
+#include <aedis/tracer.hpp>
+#include <aedis/resp3/command.hpp>
 #include <aedis/resp3/request.hpp>
+#include <aedis/resp3/request_pool.hpp>
 
 /** \mainpage Documentation
     \tableofcontents
@@ -499,6 +513,8 @@
 
     @li intro.cpp: Basic steps with Aedis.
     @li intro_sync.cpp: Synchronous version of intro.cpp.
+    @li intro_tls.cpp: Connects over TLS and resumes the session on reconnection.
+    @li tracing.cpp: Bridges the connection tracer to spans.
     @li containers.cpp: Shows how to send and receive stl containers.
     @li serialization.cpp: Shows the \c request support to serialization of user types.
     @li subscriber.cpp: Shows how to subscribe to a channel and how to reconnect when connection is lost.
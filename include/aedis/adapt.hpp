@@ -14,6 +14,7 @@
 #include <boost/utility/string_view.hpp>
 #include <boost/system.hpp>
 
+#include <aedis/error.hpp>
 #include <aedis/resp3/node.hpp>
 #include <aedis/adapter/adapt.hpp>
 #include <aedis/adapter/detail/response_traits.hpp>
@@ -47,6 +48,33 @@ struct ignore_adapter {
    auto supported_response_size() const noexcept { return std::size_t(-1);}
 };
 
+// Ignores responses but fails on errors e.g. for the responses to
+// HELLO and connection::config::init.
+struct error_adapter {
+   void
+   operator()(
+      std::size_t,
+      resp3::node<boost::string_view> const& nd,
+      boost::system::error_code& ec)
+   {
+      switch (nd.data_type) {
+         case resp3::type::simple_error: ec = error::simple_error; return;
+         case resp3::type::blob_error: ec = error::blob_error; return;
+         default: return;
+      }
+   }
+
+   void
+   operator()(
+      resp3::node<boost::string_view> const& nd,
+      boost::system::error_code& ec)
+   {
+      (*this)(0, nd, ec);
+   }
+
+   auto supported_response_size() const noexcept { return std::size_t(-1);}
+};
+
 template <class Tuple>
 class static_adapter {
 private:
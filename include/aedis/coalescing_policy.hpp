@@ -0,0 +1,81 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_COALESCING_POLICY_HPP
+#define AEDIS_COALESCING_POLICY_HPP
+
+#include <chrono>
+#include <cstddef>
+
+namespace aedis {
+
+/** \brief Decides how long a write waits for more requests.
+ *  \ingroup any
+ *
+ *  The connection writes as soon as a request arrives on an idle
+ *  connection, requests that arrive afterwards wait for the response
+ *  and are written together. Under moderate load this results in many
+ *  writes of a single request. This policy delays the write while
+ *  more requests are expected to arrive soon, based on moving
+ *  averages of the time between requests and of the round trip time
+ *  of writes.
+ *
+ *  The window is at most \c max_delay and a quarter of the round trip
+ *  time, and is zero when the mean time between requests is longer
+ *  than the window, so that there is no delay at low load. The write
+ *  happens earlier if \c max_bytes or \c max_commands are queued.
+ */
+class coalescing_policy {
+public:
+   using duration = std::chrono::nanoseconds;
+   using time_point = std::chrono::steady_clock::time_point;
+
+   /** \brief Constructor.
+    *
+    *  \param max_delay The maximum delay, zero disables the policy.
+    *  \param max_bytes Writes are not delayed once this many bytes are queued.
+    *  \param max_commands Writes are not delayed once this many commands are queued.
+    */
+   explicit
+   coalescing_policy(
+      std::chrono::microseconds max_delay = std::chrono::microseconds{0},
+      std::size_t max_bytes = 64 * 1024,
+      std::size_t max_commands = 256) noexcept;
+
+   /// Whether writes may be delayed.
+   bool enabled() const noexcept { return max_delay_.count() != 0; }
+
+   /// Records the arrival of a request.
+   void on_arrival(time_point now) noexcept;
+
+   /// Records the time between a write and the last response to it.
+   void on_round_trip(duration rtt) noexcept;
+
+   /// Whether the queued requests should be written without delay.
+   bool full(std::size_t bytes, std::size_t commands) const noexcept
+      { return bytes >= max_bytes_ || commands >= max_commands_; }
+
+   /// Returns how long to wait before writing the queued requests.
+   duration window(std::size_t bytes, std::size_t commands) const noexcept;
+
+   /// Returns the mean time between requests.
+   duration mean_gap() const noexcept { return gap_; }
+
+   /// Returns the mean round trip time.
+   duration mean_round_trip() const noexcept { return rtt_; }
+
+private:
+   duration max_delay_;
+   std::size_t max_bytes_;
+   std::size_t max_commands_;
+   duration gap_{0};
+   duration rtt_{0};
+   time_point last_arrival_{};
+};
+
+} // aedis
+
+#endif // AEDIS_COALESCING_POLICY_HPP
@@ -8,20 +8,32 @@
 #define AEDIS_CONNECTION_HPP
 
 #include <vector>
-#include <queue>
+#include <iterator>
 #include <limits>
 #include <chrono>
 #include <memory>
+#include <algorithm>
 #include <type_traits>
 
 #include <boost/assert.hpp>
+#include <boost/core/empty_value.hpp>
+#include <boost/container/deque.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/steady_timer.hpp>
 #include <boost/asio/experimental/channel.hpp>
 
 #include <aedis/adapt.hpp>
+#include <aedis/coalescing_policy.hpp>
+#include <aedis/exec_result.hpp>
+#include <aedis/latency_histogram.hpp>
+#include <aedis/reconnect_policy.hpp>
+#include <aedis/resolve_cache.hpp>
+#include <aedis/stats.hpp>
+#include <aedis/timer_wheel.hpp>
+#include <aedis/tracer.hpp>
 #include <aedis/resp3/request.hpp>
 #include <aedis/detail/connection_ops.hpp>
+#include <aedis/detail/fair_queue.hpp>
 
 namespace aedis {
 
@@ -32,9 +44,18 @@ namespace aedis {
  *  commands can be sent at any time. For more details, please see the
  *  documentation of each individual function.
  *
+ *  \tparam AsyncReadWriteStream The next layer e.g. \c tcp::socket.
+ *  \tparam Tracer Notified when requests are executed, written and
+ *  read and on each connection step, see no_tracer.
  */
-template <class AsyncReadWriteStream = boost::asio::ip::tcp::socket>
-class connection {
+template <
+   class AsyncReadWriteStream = boost::asio::ip::tcp::socket,
+   class Tracer = no_tracer
+   >
+class connection
+   : private boost::empty_value<Tracer>
+   // Empty unless AEDIS_ENABLE_LATENCY_HISTOGRAMS is defined.
+   , private boost::empty_value<detail::latency_recorder, 1> {
 public:
    /// Executor type.
    using executor_type = typename AsyncReadWriteStream::executor_type;
@@ -42,6 +63,18 @@ public:
    /// Type of the next layer
    using next_layer_type = AsyncReadWriteStream;
 
+   /// The type of the tracer.
+   using tracer_type = Tracer;
+
+   /// Customization of the next layer (e.g. for TLS), see aedis/ssl/connection.hpp.
+   using layer_type = detail::layer<AsyncReadWriteStream>;
+
+   /// The protocol of the next layer e.g. \c ip::tcp or \c local::stream_protocol.
+   using protocol_type = typename AsyncReadWriteStream::lowest_layer_type::protocol_type;
+
+   /// The endpoint type of the next layer.
+   using endpoint_type = typename protocol_type::endpoint;
+
    using default_completion_token_type = boost::asio::default_completion_token_t<executor_type>;
    using channel_type = boost::asio::experimental::channel<executor_type, void(boost::system::error_code, std::size_t)>;
    using clock_type = std::chrono::steady_clock;
@@ -58,6 +91,14 @@ public:
       /// The Redis server port.
       std::string port = "6379";
 
+      /** @brief Path of the Redis Unix domain socket.
+       *
+       *  Used instead of host and port when the next layer is a \c
+       *  local::stream_protocol socket, in which case no resolution
+       *  takes place.
+       */
+      std::string path;
+
       /// Username if authentication is required.
       std::string username;
 
@@ -67,26 +108,131 @@ public:
       /// Timeout of the resolve operation.
       std::chrono::milliseconds resolve_timeout = std::chrono::seconds{10};
 
-      /// Timeout of the connect operation.
+      /// Timeout of the connect operation and of the TLS handshake.
       std::chrono::milliseconds connect_timeout = std::chrono::seconds{10};
 
+      /** @brief Delay between connection attempts to different addresses.
+       *
+       *  When the host resolves to more than one address, IPv6 and
+       *  IPv4 addresses are tried alternately and a new attempt is
+       *  started after this delay without cancelling the previous
+       *  ones, the first to succeed is used (RFC 8305).
+       */
+      std::chrono::milliseconds connect_attempt_delay = std::chrono::milliseconds{250};
+
+      /** @brief Cache of resolved addresses.
+       *
+       *  When set, resolutions are cached and shared among all
+       *  connections using the same cache, so that reconnection
+       *  storms don't hit the DNS server. Host names that are IP
+       *  addresses are never resolved.
+       */
+      std::shared_ptr<aedis::resolve_cache> resolve_cache;
+
       /// Time interval ping operations.
       std::chrono::milliseconds ping_interval = std::chrono::seconds{1};
 
-      /// Time waited before trying a reconnection (see enable reconnect).
+      /// Minimum time waited before trying a reconnection, see reconnect_policy.
       std::chrono::milliseconds reconnect_interval = std::chrono::seconds{1};
 
+      /// Maximum time waited before trying a reconnection, see reconnect_policy.
+      std::chrono::milliseconds max_reconnect_interval = std::chrono::seconds{30};
+
+      /// Whether the first reconnection waits less than reconnect_interval.
+      bool fast_first_reconnect = true;
+
       /// The maximum size allowed on read operations.
       std::size_t max_read_size = (std::numeric_limits<std::size_t>::max)();
 
+      /** @brief Maximum capacity kept by idle buffers.
+       *
+       *  The read and write buffers are released when they become
+       *  empty and their capacity exceeds this value. Set it to zero
+       *  to release them, and the queues of waiting requests,
+       *  whenever the connection is idle, which reduces the memory
+       *  of a large number of mostly idle connections at the cost of
+       *  reallocations.
+       */
+      std::size_t max_idle_buffer_size = 64 * 1024;
+
       /// Whether to coalesce requests (see [pipelines](https://redis.io/topics/pipelining)).
       bool coalesce_requests = true;
 
+      /** @brief Maximum number of commands written in one batch.
+       *
+       *  Bounds the time a request of a higher lane (see
+       *  resp3::request::lane) waits behind a batch of lower lane
+       *  requests that were already written, e.g. the commands of a
+       *  background job. A request larger than the limit is written
+       *  alone. Zero means no limit.
+       */
+      std::size_t max_batch_commands = 0;
+
+      /** @brief Weights of the tenants.
+       *
+       *  Requests of different tenants in the same lane (see
+       *  resp3::request::tenant) are written in weighted round-robin,
+       *  tenant \c i being given \c tenant_weights[i] turns per round.
+       *  Tenants without a weight have weight one.
+       */
+      std::vector<std::size_t> tenant_weights;
+
+      /** @brief Maximum time a write waits for more requests.
+       *
+       *  The window adapts to the observed rate of requests and round
+       *  trip time, see coalescing_policy. Zero disables the delay.
+       */
+      std::chrono::microseconds max_coalesce_delay{0};
+
+      /// Writes are not delayed once this many bytes are queued.
+      std::size_t coalesce_bytes = 64 * 1024;
+
+      /// Writes are not delayed once this many commands are queued.
+      std::size_t coalesce_commands = 256;
+
+      /** @brief Commands sent on every connection together with HELLO.
+       *
+       *  The request is written in the same write as \c AUTH and \c
+       *  HELLO, e.g. \c CLIENT \c SETNAME, \c SELECT or \c SUBSCRIBE,
+       *  and sent again on every reconnection. The connection is
+       *  ready, and event::hello is sent, only after all of its
+       *  responses were received. Their values are ignored but an
+       *  error response fails the connection attempt with
+       *  error::simple_error or error::blob_error. Commands whose
+       *  response is a push e.g. \c SUBSCRIBE must come after all
+       *  others, their pushes are received as event::push.
+       */
+      resp3::request init;
+
       /// Enable events
       bool enable_events = false;
 
       /// Enable automatic reconnection (see also reconnect_interval).
       bool enable_reconnect = false;
+
+      /** @brief Timer wheel that drives the health checks.
+       *
+       *  When set, the health checks of all connections sharing the
+       *  wheel are driven by its single timer instead of a timer per
+       *  connection. The wheel must run on the same executor as the
+       *  connection.
+       */
+      std::shared_ptr<timer_wheel> wheel;
+   };
+
+   /// Information about the current reconnection, see event::reconnect.
+   struct reconnect_info {
+      /// The attempt number, starting at one after each successful connection.
+      std::size_t attempt = 0;
+
+      /// The time that will be waited before this attempt.
+      std::chrono::milliseconds delay{0};
+
+      /// When the connection was lost or the first attempt failed.
+      clock_type::time_point disconnected_at{};
+
+      /// The error that caused this attempt.
+      boost::system::error_code error;
    };
 
    /// Events communicated through \c async_receive_event.
@@ -99,6 +245,8 @@ public:
       hello,
       /// A push event has been received.
       push,
+      /// A reconnection will be attempted, see \c get_reconnect_info.
+      reconnect,
       /// Used internally.
       invalid
    };
@@ -109,18 +257,24 @@ public:
     *  \param cfg Configuration parameters.
     */
    connection(executor_type ex, config cfg = config{})
-   : resv_{ex}
-   , ping_timer_{ex}
-   , check_idle_timer_{ex}
-   , writer_timer_{ex}
-   , read_timer_{ex}
-   , push_channel_{ex}
-   , cfg_{cfg}
-   , last_data_{std::chrono::time_point<std::chrono::steady_clock>::min()}
-   {
-      writer_timer_.expires_at(std::chrono::steady_clock::time_point::max());
-      read_timer_.expires_at(std::chrono::steady_clock::time_point::max());
-   }
+   : connection(ex, layer_type{}, std::move(cfg))
+   { }
+
+   /** \brief Construct a connection from an executor and the argument of the next layer.
+    *
+    *  For example the \c boost::asio::ssl::context of TLS
+    *  connections, see aedis/ssl/connection.hpp.
+    *
+    *  \param ex The executor.
+    *  \param arg Argument used to construct the next layer.
+    *  \param cfg Configuration parameters.
+    */
+   template <
+      class Arg,
+      class = std::enable_if_t<std::is_constructible<layer_type, Arg&>::value>>
+   connection(executor_type ex, Arg& arg, config cfg = config{})
+   : connection(ex, layer_type{arg}, std::move(cfg))
+   { }
 
    /** \brief Construct a connection from an io_context.
     *
@@ -131,8 +285,21 @@ public:
    : connection(ioc.get_executor(), cfg)
    { }
 
+   /** \brief Construct a connection from an io_context and the argument of the next layer.
+    *
+    *  \param ioc The executor.
+    *  \param arg Argument used to construct the next layer.
+    *  \param cfg Configuration parameters.
+    */
+   template <
+      class Arg,
+      class = std::enable_if_t<std::is_constructible<layer_type, Arg&>::value>>
+   connection(boost::asio::io_context& ioc, Arg& arg, config cfg = config{})
+   : connection(ioc.get_executor(), arg, std::move(cfg))
+   { }
+
    /// Returns the executor.
-   auto get_executor() {return resv_.get_executor();}
+   auto get_executor() {return ex_;}
 
    /** @brief Starts communication with the Redis server asynchronously.
     *
@@ -144,14 +311,11 @@ public:
     *  \li Connects to one of the endpoints returned by the resolve
     *  operation with the timeout passed in connection::config::connect_timeout.
     *
-    *  \li Starts the idle check operation with the timeout of twice
-    *  the value of connection::config::ping_interval. If no data is
-    *  received during that time interval \c async_run completes with
-    *  error::idle_timeout.
-    *
-    *  \li Starts the healthy check operation that sends command::ping
-    *  to Redis with a frequency equal to
-    *  connection::config::ping_interval.
+    *  \li Starts the health check operation that runs every
+    *  connection::config::ping_interval. It sends a \c PING only if
+    *  no data was received during the last interval. If outstanding
+    *  requests receive no data for twice that interval \c async_run
+    *  completes with error::idle_timeout.
     *
     *  \li Starts reading from the socket and delivering events to the
     *  request started with \c async_exec and \c async_receive_event.
@@ -174,7 +338,7 @@ public:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::run_op<connection>{this}, token, resv_);
+         >(detail::run_op<connection>{this}, token, ex_);
    }
 
    /** @brief Executes a command on the redis server asynchronously.
@@ -194,10 +358,11 @@ public:
     *  bytes.
     */
    template <
+      class Allocator,
       class Adapter = detail::response_traits<void>::adapter_type,
       class CompletionToken = default_completion_token_type>
    auto async_exec(
-      resp3::request const& req,
+      resp3::basic_request<Allocator> const& req,
       Adapter adapter = adapt(),
       CompletionToken token = CompletionToken{})
    {
@@ -206,7 +371,49 @@ public:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code, std::size_t)
-         >(detail::exec_op<connection, Adapter>{this, &req, adapter}, token, resv_);
+         >(detail::exec_op<connection, Adapter>{this, req, adapter}, token, ex_);
+   }
+
+   /** @brief Executes many requests with a single completion.
+    *
+    *  The requests are queued atomically and written together, as if
+    *  they were a single request, which saves the per operation cost
+    *  of calling \c async_exec for each of them, e.g. in bulk jobs.
+    *  Their payloads are only copied to the write buffer. The lane and
+    *  tenant of the batch are those of its first request, the
+    *  statistics see it as a single request and the tracer sees each
+    *  request.
+    *
+    *  \param reqs Range of requests, must outlive the operation.
+    *  \param adapters Range of response adapters of the same size,
+    *  must outlive the operation.
+    *  \param token Asio completion token.
+    *
+    *  The completion token must have the following signature
+    *
+    *  @code
+    *  void f(boost::system::error_code, std::vector<exec_result>);
+    *  @endcode
+    *
+    *  Where the second parameter contains the result of each
+    *  request. The error code is that of the first request that
+    *  failed, the requests after it fail with the same error.
+    */
+   template <
+      class Requests,
+      class Adapters,
+      class CompletionToken = default_completion_token_type>
+   auto async_exec_batch(
+      Requests const& reqs,
+      Adapters const& adapters,
+      CompletionToken token = CompletionToken{})
+   {
+      BOOST_ASSERT_MSG(std::size(reqs) == std::size(adapters), "Requests and adapters have different sizes.");
+
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::vector<exec_result>)
+         >(detail::exec_batch_op<connection, Requests, Adapters>{this, &reqs, &adapters}, token, ex_);
    }
 
    /** @brief Connects and executes a request asynchronously.
@@ -228,18 +435,19 @@ public:
     *  Where the second parameter is the size of the response in bytes.
     */
    template <
+      class Allocator,
       class Adapter = detail::response_traits<void>::adapter_type,
       class CompletionToken = default_completion_token_type>
    auto async_run(
-      resp3::request const& req,
+      resp3::basic_request<Allocator> const& req,
       Adapter adapter = adapt(),
       CompletionToken token = CompletionToken{})
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code, std::size_t)
-         >(detail::runexec_op<connection, Adapter>
-            {this, &req, adapter}, token, resv_);
+         >(detail::runexec_op<connection, resp3::basic_request<Allocator>, Adapter>
+            {this, &req, adapter}, token, ex_);
    }
 
    /** @brief Receives unsolicited events asynchronously.
@@ -278,7 +486,7 @@ public:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code, event)
-         >(detail::receive_op<connection, decltype(f)>{this, f}, token, resv_);
+         >(detail::receive_op<connection, decltype(f)>{this, f}, token, ex_);
    }
 
    /** @brief Cancel all pending request.
@@ -287,13 +495,17 @@ public:
     */
    std::size_t cancel_execs()
    {
-      for (auto& e: reqs_) {
-         e->stop = true;
-         e->timer.cancel_one();
-      }
+      auto const cancel = [](auto const& ptr) {
+         ptr->stop = true;
+         ptr->timer.cancel_one();
+      };
+
+      std::for_each(std::begin(reqs_), std::end(reqs_), cancel);
+      waiting_.for_each(cancel);
 
-      auto const ret = reqs_.size();
+      auto const ret = reqs_.size() + waiting_.size();
       reqs_ = {};
+      waiting_.clear();
       return ret;
    }
 
@@ -316,17 +528,20 @@ public:
     */
    void cancel_run()
    {
-      if (socket_)
-         socket_->close();
+      health_entry_.cancel();
+
+      if (socket_) {
+         layer_.on_close(*socket_);
+         socket_->lowest_layer().close();
+      }
 
       read_timer_.cancel();
-      check_idle_timer_.cancel();
       writer_timer_.cancel();
       ping_timer_.cancel();
 
       // Cancel own pings if there is any waiting.
       auto point = std::stable_partition(std::begin(reqs_), std::end(reqs_), [](auto const& ptr) {
-         return !ptr->req->close_on_run_completion;
+         return !ptr->req.close_on_run_completion;
       });
 
       std::for_each(point, std::end(reqs_), [](auto const& ptr) {
@@ -335,6 +550,15 @@ public:
       });
 
       reqs_.erase(point, std::end(reqs_));
+
+      waiting_.remove_if([](auto const& ptr) {
+         if (!ptr->req.close_on_run_completion)
+            return false;
+
+         ptr->stop = true;
+         ptr->timer.cancel();
+         return true;
+      });
    }
 
    /// Cancels the event receiver.
@@ -349,18 +573,114 @@ public:
    /// Gets the config object.
    config const& get_config() const noexcept { return cfg_;}
 
+   /** @brief Returns information about the last reconnection.
+    *
+    *  Updated before event::reconnect is delivered and kept until the
+    *  next disconnection, so that the recovery time can be measured
+    *  on event::hello as <tt>now - disconnected_at</tt>.
+    */
+   reconnect_info const& get_reconnect_info() const noexcept
+      { return reconnect_info_; }
+
+   /** @brief Returns a snapshot of the counters of the connection.
+    *
+    *  Counters accumulate across reconnections. This function is
+    *  thread safe, the counters are relaxed atomics written only by
+    *  the connection, so reading them from another thread does not
+    *  slow it down. See also aedis::to_prometheus.
+    */
+   connection_stats stats() const noexcept
+      { return stats_.snapshot(); }
+
+   /// Returns the tracer.
+   tracer_type& get_tracer() noexcept
+      { return boost::empty_value<Tracer>::get(); }
+
+   /// Returns the tracer.
+   tracer_type const& get_tracer() const noexcept
+      { return boost::empty_value<Tracer>::get(); }
+
+#if defined(AEDIS_ENABLE_LATENCY_HISTOGRAMS)
+   /** @brief Returns the latency histograms of the requests.
+    *
+    *  Every request executed with \c async_exec is timed when it is
+    *  queued, when its write starts and completes, when the first
+    *  byte of its response is received and when the response is
+    *  parsed. Only available when \c AEDIS_ENABLE_LATENCY_HISTOGRAMS
+    *  is defined, otherwise the timestamps are not taken at all. The
+    *  macro must be defined in all translation units or in none, see
+    *  latency_histograms.
+    */
+   latency_histograms& get_latency_histograms() noexcept
+      { return get_latency_recorder().histograms(); }
+
+   /// Returns the latency histograms of the requests.
+   latency_histograms const& get_latency_histograms() const noexcept
+      { return get_latency_recorder().histograms(); }
+#endif // AEDIS_ENABLE_LATENCY_HISTOGRAMS
+
+   /** @brief Returns the next layer of the current connection.
+    *
+    *  Useful to inspect the TLS session for example. Must not be
+    *  called before \c async_run connects.
+    */
+   next_layer_type& next_layer() noexcept
+   {
+      BOOST_ASSERT(socket_ != nullptr);
+      return *socket_;
+   }
+
 private:
+   connection(executor_type ex, layer_type layer, config cfg)
+   : ex_{ex}
+   , ping_timer_{ex}
+   , writer_timer_{ex}
+   , read_timer_{ex}
+   , push_channel_{ex}
+   , cfg_{std::move(cfg)}
+   , layer_{std::move(layer)}
+   , last_data_{std::chrono::time_point<std::chrono::steady_clock>::min()}
+   , health_entry_{&connection::on_health_check, this}
+   {
+      writer_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+      read_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+   }
+
+   detail::latency_recorder& get_latency_recorder() noexcept
+      { return boost::empty_value<detail::latency_recorder, 1>::get(); }
+
+   detail::latency_recorder const& get_latency_recorder() const noexcept
+      { return boost::empty_value<detail::latency_recorder, 1>::get(); }
+
    struct req_info {
       req_info(executor_type ex) : timer{ex} {}
+
+      // The requests written together, only req unless executed with
+      // async_exec_batch.
+      resp3::request_view const* begin() const noexcept
+         { return parts == nullptr ? &req : parts; }
+      resp3::request_view const* end() const noexcept
+         { return parts == nullptr ? &req + 1 : parts + parts_size; }
+
       timer_type timer;
-      resp3::request const* req = nullptr;
+      // The request, or the first of a batch, its lane and tenant are
+      // those of the batch.
+      resp3::request_view req;
+      resp3::request_view const* parts = nullptr;
+      std::size_t parts_size = 0;
+      // The commands and the bytes of all requests.
       std::size_t cmds = 0;
+      std::size_t bytes = 0;
       bool stop = false;
       bool written = false;
+      detail::latency_marks marks;
    };
 
    using time_point_type = std::chrono::time_point<std::chrono::steady_clock>;
-   using reqs_type = std::deque<std::shared_ptr<req_info>>;
+   // Unlike std::deque, does not allocate when empty.
+   using reqs_type = boost::container::deque<std::shared_ptr<req_info>>;
+   // One lane per resp3::priority_lane.
+   using waiting_type = detail::fair_queue<std::shared_ptr<req_info>, 3>;
 
    template <class T, class U> friend struct detail::receive_op;
    template <class T> friend struct detail::reader_op;
@@ -370,10 +690,12 @@ private:
    template <class T> friend struct detail::run_one_op;
    template <class T, class U> friend struct detail::exec_op;
    template <class T, class U> friend struct detail::exec_read_op;
-   template <class T, class U> friend struct detail::runexec_op;
+   template <class T, class U, class V> friend struct detail::exec_batch_op;
+   template <class T, class U, class V> friend struct detail::runexec_op;
    template <class T> friend struct detail::connect_with_timeout_op;
+   template <class T> friend struct detail::handshake_with_timeout_op;
    template <class T> friend struct detail::resolve_with_timeout_op;
-   template <class T> friend struct detail::check_idle_op;
+   template <class T> friend struct detail::resolve_local_op;
    template <class T> friend struct detail::start_op;
    template <class T> friend struct detail::send_receive_op;
 
@@ -383,13 +705,67 @@ private:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::run_one_op<connection>{this}, token, resv_);
+         >(detail::run_one_op<connection>{this}, token, ex_);
+   }
+
+   // Called every ping_interval while running. Returns false after
+   // closing the connection if it is stalled.
+   bool check_health()
+   {
+      auto const now = std::chrono::steady_clock::now();
+      auto const interval = cfg_.ping_interval;
+
+      if (cmds_ != 0) {
+         // The oldest outstanding request was written at last_write_
+         // at the latest.
+         if ((std::max)(last_data_, last_write_) + 2 * interval < now) {
+            health_ec_ = error::idle_timeout;
+            cancel_run();
+            return false;
+         }
+      } else if (!ping_pending_ && last_data_ + interval <= now) {
+         // The ping is not waited for, its response is accounted as
+         // an outstanding request above.
+         if (ping_req_.size() == 0) {
+            ping_req_.push("PING");
+            ping_req_.close_on_run_completion = true;
+            ping_req_.lane = resp3::priority_lane::high;
+         }
+
+         ping_pending_ = true;
+         async_exec(ping_req_, adapt(), [this](auto, auto) { ping_pending_ = false; });
+      }
+
+      return true;
+   }
+
+   static void on_health_check(void* data)
+   {
+      auto* self = static_cast<connection*>(data);
+      if (self->check_health())
+         self->cfg_.wheel->arm(self->health_entry_, self->cfg_.ping_interval);
+   }
+
+   void release_idle_buffers()
+   {
+      auto const release = [max = cfg_.max_idle_buffer_size](std::string& buffer) {
+         if (buffer.empty() && buffer.capacity() > max)
+            std::string{}.swap(buffer);
+      };
+
+      stats_.update_max(stats_.read_buffer_high_water, read_buffer_.capacity());
+      release(read_buffer_);
+      release(write_buffer_);
+
+      // The queues of the lanes keep their capacity otherwise.
+      if (cfg_.max_idle_buffer_size == 0 && waiting_.empty())
+         waiting_.clear();
    }
 
    void cancel_push_requests()
    {
       auto point = std::stable_partition(std::begin(reqs_), std::end(reqs_), [](auto const& ptr) {
-         return !(ptr->written && ptr->req->size() == 0);
+         return !(ptr->written && ptr->cmds == 0);
       });
 
       std::for_each(point, std::end(reqs_), [](auto const& ptr) {
@@ -401,8 +777,24 @@ private:
 
    void add_request_info(std::shared_ptr<req_info> const& info)
    {
-      reqs_.push_back(info);
-      if (socket_ != nullptr && socket_->is_open() && cmds_ == 0 && write_buffer_.empty())
+      if (coalesce_.enabled())
+         coalesce_.on_arrival(std::chrono::steady_clock::now());
+
+      get_latency_recorder().on_enqueue(info->marks);
+      stats_.add(stats_.requests_queued);
+      for (auto const& req: *info)
+         get_tracer().on_exec(req);
+
+      waiting_.push_back(lane_index(*info), info->req.tenant, tenant_weight(info->req.tenant), info);
+
+      if (coalescing_) {
+         coalesce_bytes_ += info->bytes;
+         coalesce_cmds_ += info->cmds;
+         if (!coalesce_.full(coalesce_bytes_, coalesce_cmds_))
+            return;
+      }
+
+      if (socket_ != nullptr && socket_->lowest_layer().is_open() && cmds_ == 0 && write_buffer_.empty())
          writer_timer_.cancel();
    }
 
@@ -412,11 +804,17 @@ private:
    template <class CompletionToken>
    auto async_resolve_with_timeout(CompletionToken&& token)
    {
+      using op_type =
+         typename std::conditional<
+            detail::is_local_protocol<protocol_type>::value,
+            detail::resolve_local_op<connection>,
+            detail::resolve_with_timeout_op<connection>
+         >::type;
+
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::resolve_with_timeout_op<connection>{this},
-            token, resv_);
+         >(op_type{this}, token, ex_);
    }
 
    template <class CompletionToken>
@@ -425,53 +823,53 @@ private:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::connect_with_timeout_op<connection>{this}, token, resv_);
+         >(detail::connect_with_timeout_op<connection>{this}, token, ex_);
    }
 
    template <class CompletionToken>
-   auto reader(CompletionToken&& token)
+   auto async_handshake_with_timeout(CompletionToken&& token)
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::reader_op<connection>{this}, token, resv_.get_executor());
+         >(detail::handshake_with_timeout_op<connection>{this}, token, ex_);
    }
 
    template <class CompletionToken>
-   auto writer(CompletionToken&& token)
+   auto reader(CompletionToken&& token)
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::writer_op<connection>{this}, token, resv_.get_executor());
+         >(detail::reader_op<connection>{this}, token, ex_);
    }
 
    template <class CompletionToken>
-   auto
-   async_start(CompletionToken&& token)
+   auto writer(CompletionToken&& token)
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::start_op<connection>{this}, token, resv_);
+         >(detail::writer_op<connection>{this}, token, ex_);
    }
 
    template <class CompletionToken>
-   auto async_ping(CompletionToken&& token)
+   auto
+   async_start(CompletionToken&& token)
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::ping_op<connection>{this}, token, resv_);
+         >(detail::start_op<connection>{this}, token, ex_);
    }
 
    template <class CompletionToken>
-   auto async_check_idle(CompletionToken&& token)
+   auto async_ping(CompletionToken&& token)
    {
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code)
-         >(detail::check_idle_op<connection>{this}, token, check_idle_timer_);
+         >(detail::ping_op<connection>{this}, token, ex_);
    }
 
    template <class Adapter, class CompletionToken>
@@ -480,7 +878,7 @@ private:
       return boost::asio::async_compose
          < CompletionToken
          , void(boost::system::error_code, std::size_t)
-         >(detail::exec_read_op<connection, Adapter>{this, adapter, cmds}, token, resv_);
+         >(detail::exec_read_op<connection, Adapter>{this, adapter, cmds}, token, ex_);
    }
 
    void coalesce_requests()
@@ -488,61 +886,183 @@ private:
       // Coaleces all requests: Copies the request to the variables
       // that won't be touched while async_write is suspended.
       BOOST_ASSERT(write_buffer_.empty());
-      BOOST_ASSERT(!reqs_.empty());
+      BOOST_ASSERT(write_externals_.empty());
+      BOOST_ASSERT(!waiting_.empty());
+
+      auto const max = cfg_.coalesce_requests ? waiting_.size() : 1;
+      auto size = 0UL;
+      for (; size < max; ++size) {
+         auto const limit = cfg_.max_batch_commands;
+         if (size != 0 && limit != 0 && cmds_ + waiting_.front()->cmds > limit)
+            break;
+
+         reqs_.push_back(waiting_.pop());
+         auto& info = *reqs_.back();
+         get_latency_recorder().on_write_start(info.marks);
+         for (auto const& req: info) {
+            for (auto const& e: req.externals())
+               write_externals_.push_back({write_buffer_.size() + e.offset, e.arg});
+
+            write_buffer_.append(req.payload().data(), req.payload().size());
+            get_tracer().on_write_begin(req, req.payload().size());
+         }
+
+         cmds_ += info.cmds;
+         info.written = true;
+      }
 
-      auto const size = cfg_.coalesce_requests ? reqs_.size() : 1;
-      for (auto i = 0UL; i < size; ++i) {
-         write_buffer_ += reqs_.at(i)->req->payload();
-         cmds_ += reqs_.at(i)->req->size();
-         reqs_.at(i)->written = true;
+      stats_.on_batch(size);
+   }
+
+   // The coalesced payloads interleaved with the external arguments
+   // of the requests, which are not copied.
+   auto const& make_write_buffers()
+   {
+      write_buffers_.clear();
+      std::size_t pos = 0;
+      for (auto const& e: write_externals_) {
+         write_buffers_.push_back(boost::asio::buffer(write_buffer_.data() + pos, e.offset - pos));
+         write_buffers_.push_back(e.arg.data);
+         pos = e.offset;
+      }
+
+      write_buffers_.push_back(boost::asio::buffer(write_buffer_.data() + pos, write_buffer_.size() - pos));
+      return write_buffers_;
+   }
+
+   // Returns true if the write of the queued requests should be
+   // delayed, the writer timer then expires at the end of the window.
+   bool start_coalescing()
+   {
+      if (!coalesce_.enabled())
+         return false;
+
+      coalesce_bytes_ = 0;
+      coalesce_cmds_ = 0;
+      waiting_.for_each([this](auto const& ptr) {
+         coalesce_bytes_ += ptr->bytes;
+         coalesce_cmds_ += ptr->cmds;
+      });
+
+      auto const window = coalesce_.window(coalesce_bytes_, coalesce_cmds_);
+      if (window.count() == 0)
+         return false;
+
+      coalescing_ = true;
+      writer_timer_.expires_after(window);
+      return true;
+   }
+
+   void stop_coalescing()
+   {
+      coalescing_ = false;
+      writer_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+   }
+
+   // Called when the responses to all written requests were read.
+   void on_batch_complete()
+   {
+      if (coalesce_.enabled())
+         coalesce_.on_round_trip(std::chrono::steady_clock::now() - last_write_);
+   }
+
+   static std::size_t lane_index(req_info const& info) noexcept
+      { return static_cast<std::size_t>(info.req.lane); }
+
+   std::size_t tenant_weight(std::size_t tenant) const noexcept
+      { return tenant < cfg_.tenant_weights.size() ? cfg_.tenant_weights[tenant] : std::size_t{1}; }
+
+   // Requests whose responses were not read are written again after
+   // a reconnection, before the other requests of their tenant.
+   void requeue_requests()
+   {
+      while (!reqs_.empty()) {
+         auto info = std::move(reqs_.back());
+         reqs_.pop_back();
+         info->written = false;
+         waiting_.push_front(lane_index(*info), info->req.tenant, tenant_weight(info->req.tenant), std::move(info));
       }
    }
 
    // IO objects
-   resolver_type resv_;
+   executor_type ex_;
    std::shared_ptr<AsyncReadWriteStream> socket_;
    timer_type ping_timer_;
-   timer_type check_idle_timer_;
    timer_type writer_timer_;
    timer_type read_timer_;
    channel_type push_channel_;
 
    config cfg_;
+   layer_type layer_;
    std::string read_buffer_;
    std::string write_buffer_;
+   // Also keeps the owners alive while writing.
+   std::vector<resp3::request::external_segment> write_externals_;
+   std::vector<boost::asio::const_buffer> write_buffers_;
    std::size_t cmds_ = 0;
+   // The requests written, in the order of their responses.
    reqs_type reqs_;
+   // The requests waiting to be written.
+   waiting_type waiting_;
    event last_event_ = event::invalid;
 
    // Last time we received data.
    time_point_type last_data_;
 
+   // Last time we started writing.
+   time_point_type last_write_ = time_point_type::min();
+
+   // Whether a health check PING is waiting for its response.
+   bool ping_pending_ = false;
+
+   // Error of the last health check and its timer wheel entry.
+   boost::system::error_code health_ec_;
+   timer_wheel::entry health_entry_;
+
+   reconnect_policy reconnect_;
+   reconnect_info reconnect_info_;
+
+   // Whether the writer is waiting for more requests and what is
+   // queued meanwhile.
+   coalescing_policy coalesce_;
+   bool coalescing_ = false;
+   std::size_t coalesce_bytes_ = 0;
+   std::size_t coalesce_cmds_ = 0;
+
+   detail::stats_counters stats_;
+
    // The result of async_resolve.
-   boost::asio::ip::tcp::resolver::results_type endpoints_;
+   std::vector<endpoint_type> endpoints_;
 
+   // The HELLO request of run_one_op, rebuilt on every reconnection.
    resp3::request req_;
+
+   // The health check PING, built once and never changed afterwards
+   // since the connection keeps views of it while it is queued.
+   resp3::request ping_req_;
 };
 
 /// Converts a connection event to a string.
-template <class T>
-char const* to_string(typename connection<T>::event e)
+template <class T, class Tracer = no_tracer>
+char const* to_string(typename connection<T, Tracer>::event e)
 {
-   using event_type = typename connection<T>::event;
+   using event_type = typename connection<T, Tracer>::event;
    switch (e) {
       case event_type::resolve: return "resolve";
       case event_type::connect: return "connect";
       case event_type::hello: return "hello";
       case event_type::push: return "push";
+      case event_type::reconnect: return "reconnect";
       case event_type::invalid: return "invalid";
       default: BOOST_ASSERT_MSG(false, "to_string: unhandled event.");
    }
 }
 
 /// Writes a connection event to the stream.
-template <class T>
-std::ostream& operator<<(std::ostream& os, typename connection<T>::event e)
+template <class T, class Tracer = no_tracer>
+std::ostream& operator<<(std::ostream& os, typename connection<T, Tracer>::event e)
 {
-   os << to_string(e);
+   os << to_string<T, Tracer>(e);
    return os;
 }
 
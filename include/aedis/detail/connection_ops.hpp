@@ -8,16 +8,24 @@
 #define AEDIS_CONNECTION_OPS_HPP
 
 #include <array>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iterator>
 #include <algorithm>
 
 #include <boost/assert.hpp>
 #include <boost/system.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/write.hpp>
 #include <boost/core/ignore_unused.hpp>
 #include <boost/asio/experimental/parallel_group.hpp>
 
 #include <aedis/adapt.hpp>
 #include <aedis/error.hpp>
+#include <aedis/exec_result.hpp>
+#include <aedis/coalescing_policy.hpp>
+#include <aedis/reconnect_policy.hpp>
 #include <aedis/detail/net.hpp>
 #include <aedis/resp3/type.hpp>
 #include <aedis/resp3/detail/exec.hpp>
@@ -40,23 +48,80 @@ struct connect_with_timeout_op {
    boost::asio::coroutine coro{};
 
    template <class Self>
-   void operator()( Self& self
-                  , boost::system::error_code ec = {}
-                  , boost::asio::ip::tcp::endpoint const& = {})
+   void operator()(Self& self, boost::system::error_code ec = {})
    {
       reenter (coro)
       {
          BOOST_ASSERT(conn->socket_ != nullptr);
          conn->ping_timer_.expires_after(conn->cfg_.connect_timeout);
-         yield aedis::detail::async_connect(*conn->socket_, conn->ping_timer_, conn->endpoints_, std::move(self));
+         yield
+         aedis::detail::async_connect(
+            conn->socket_->lowest_layer(), conn->ping_timer_,
+            conn->endpoints_, conn->cfg_.connect_attempt_delay,
+            std::move(self));
          self.complete(ec);
       }
    }
 };
 
+template <class Conn>
+struct handshake_with_timeout_op {
+   Conn* conn;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void operator()( Self& self
+                  , std::array<std::size_t, 2> order = {}
+                  , boost::system::error_code ec1 = {}
+                  , boost::system::error_code ec2 = {})
+   {
+      reenter (coro)
+      {
+         BOOST_ASSERT(conn->socket_ != nullptr);
+         conn->ping_timer_.expires_after(conn->cfg_.connect_timeout);
+
+         yield
+         boost::asio::experimental::make_parallel_group(
+            [this](auto token) { return conn->layer_.async_handshake(*conn->socket_, conn->cfg_.host, token);},
+            [this](auto token) { return conn->ping_timer_.async_wait(token);}
+         ).async_wait(
+            boost::asio::experimental::wait_for_one(),
+            std::move(self));
+
+         switch (order[0]) {
+            case 0:
+            {
+               if (ec1) {
+                  self.complete(ec1);
+                  return;
+               }
+            } break;
+
+            case 1:
+            {
+               // The handshake did not finish, e.g. cancel_run
+               // cancelled the timer.
+               if (ec2)
+                  self.complete(ec2);
+               else
+                  self.complete(error::handshake_timeout);
+
+               return;
+            }
+
+            default: BOOST_ASSERT(false);
+         }
+
+         self.complete({});
+      }
+   }
+};
+
 template <class Conn>
 struct resolve_with_timeout_op {
    Conn* conn;
+   // The resolver only exists during the resolution.
+   std::unique_ptr<typename Conn::resolver_type> resv = nullptr;
    boost::asio::coroutine coro{};
 
    template <class Self>
@@ -64,15 +129,67 @@ struct resolve_with_timeout_op {
                   , boost::system::error_code ec = {}
                   , boost::asio::ip::tcp::resolver::results_type res = {})
    {
+      auto const& cfg = conn->cfg_;
+      boost::asio::ip::tcp::endpoint ep;
+
       reenter (coro)
       {
-         conn->ping_timer_.expires_after(conn->cfg_.resolve_timeout);
+         // IP addresses don't need a resolver.
+         if (make_literal_endpoint(cfg.host, cfg.port, ep)) {
+            conn->endpoints_ = {ep};
+            yield boost::asio::post(std::move(self));
+            self.complete({});
+            return;
+         }
+
+         if (cfg.resolve_cache && cfg.resolve_cache->find(cfg.host, cfg.port, conn->endpoints_)) {
+            yield boost::asio::post(std::move(self));
+            self.complete({});
+            return;
+         }
+
+         resv = std::make_unique<typename Conn::resolver_type>(conn->ex_);
+         conn->ping_timer_.expires_after(cfg.resolve_timeout);
          yield
          aedis::detail::async_resolve(
-            conn->resv_, conn->ping_timer_,
-            conn->cfg_.host, conn->cfg_.port, std::move(self));
-         conn->endpoints_ = res;
-         self.complete(ec);
+            *resv, conn->ping_timer_,
+            cfg.host, cfg.port, std::move(self));
+         resv = nullptr;
+
+         if (ec) {
+            // A stale address is better than none when the DNS server
+            // is unreachable.
+            if (cfg.resolve_cache && cfg.resolve_cache->find(cfg.host, cfg.port, conn->endpoints_, true))
+               ec = {};
+
+            self.complete(ec);
+            return;
+         }
+
+         conn->endpoints_ = interleave_families(res);
+         if (cfg.resolve_cache)
+            cfg.resolve_cache->insert(cfg.host, cfg.port, conn->endpoints_);
+
+         self.complete({});
+      }
+   }
+};
+
+// Unix domain sockets are not resolved, the endpoint is the path in
+// the config.
+template <class Conn>
+struct resolve_local_op {
+   Conn* conn;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void operator()(Self& self)
+   {
+      reenter (coro)
+      {
+         conn->endpoints_ = {typename Conn::endpoint_type{conn->cfg_.path}};
+         yield boost::asio::post(std::move(self));
+         self.complete({});
       }
    }
 };
@@ -108,6 +225,9 @@ struct receive_op {
             }
 
             read_size = n;
+            conn->stats_.add(conn->stats_.pushes_received);
+            conn->stats_.add(conn->stats_.bytes_read, n);
+            conn->release_idle_buffers();
          }
 
          yield conn->push_channel_.async_send({}, 0, std::move(self));
@@ -201,7 +321,7 @@ struct exec_op {
    using req_info_type = typename Conn::req_info;
 
    Conn* conn = nullptr;
-   resp3::request const* req = nullptr;
+   resp3::request_view req;
    Adapter adapter{};
    std::shared_ptr<req_info_type> info = nullptr;
    std::size_t read_size = 0;
@@ -215,10 +335,11 @@ struct exec_op {
    {
       reenter (coro)
       {
-         info = std::allocate_shared<req_info_type>(boost::asio::get_associated_allocator(self), conn->resv_.get_executor());
+         info = std::allocate_shared<req_info_type>(boost::asio::get_associated_allocator(self), conn->ex_);
          info->timer.expires_at(std::chrono::steady_clock::time_point::max());
          info->req = req;
-         info->cmds = req->size();
+         info->cmds = req.size();
+         info->bytes = req.payload().size() + req.external_size();
          info->stop = false;
 
          conn->add_request_info(info);
@@ -226,13 +347,17 @@ struct exec_op {
          BOOST_ASSERT(conn->socket_ != nullptr);
          BOOST_ASSERT(!!ec);
          if (info->stop) {
+            conn->stats_.add(conn->stats_.requests_failed);
+            conn->get_tracer().on_response_end(req, ec, 0);
             self.complete(ec, 0);
             return;
          }
 
-         BOOST_ASSERT(conn->socket_->is_open());
+         BOOST_ASSERT(conn->socket_->lowest_layer().is_open());
           
-         if (req->size() == 0) {
+         if (req.size() == 0) {
+            conn->stats_.add(conn->stats_.requests_completed);
+            conn->get_tracer().on_response_end(req, {}, 0);
             self.complete({}, 0);
             return;
          }
@@ -240,20 +365,32 @@ struct exec_op {
          BOOST_ASSERT(!conn->reqs_.empty());
          BOOST_ASSERT(conn->reqs_.front() != nullptr);
          BOOST_ASSERT(conn->cmds_ != 0);
+         conn->get_tracer().on_response_begin(req);
+         // Only the first request of a pipeline is woken up by the
+         // reader, the others are resumed by the previous one.
+         conn->get_latency_recorder().on_first_byte(info->marks);
          yield conn->async_exec_read(adapter, conn->reqs_.front()->cmds, std::move(self));
          if (ec) {
+            conn->stats_.add(conn->stats_.requests_failed);
+            conn->get_tracer().on_response_end(req, ec, n);
             self.complete(ec, 0);
             return;
          }
 
          read_size = n;
+         conn->stats_.add(conn->stats_.requests_completed);
+         conn->stats_.add(conn->stats_.bytes_read, n);
+         conn->get_tracer().on_response_end(req, {}, n);
+         conn->get_latency_recorder().on_parsed(info->marks);
 
          BOOST_ASSERT(!conn->reqs_.empty());
          conn->reqs_.pop_front();
 
          if (conn->cmds_ == 0) {
+            conn->on_batch_complete();
+            conn->release_idle_buffers();
             conn->read_timer_.cancel_one();
-            if (!conn->reqs_.empty())
+            if (!conn->waiting_.empty())
                conn->writer_timer_.cancel_one();
          } else {
             BOOST_ASSERT(!conn->reqs_.empty());
@@ -265,69 +402,176 @@ struct exec_op {
    }
 };
 
-template <class Conn>
-struct ping_op {
-   Conn* conn;
+// Executes many requests as a single one. The op keeps a view of each
+// request, their payloads are written together, and their responses
+// are read in sequence with their adapters.
+template <class Conn, class Requests, class Adapters>
+struct exec_batch_op {
+   using req_info_type = typename Conn::req_info;
+   using adapter_iterator = decltype(std::cbegin(std::declval<Adapters const&>()));
+
+   struct state {
+      template <class Executor>
+      explicit state(Executor ex) : info{ex} {}
+
+      req_info_type info;
+      std::vector<resp3::request_view> views;
+      std::vector<exec_result> results;
+   };
+
+   Conn* conn = nullptr;
+   Requests const* reqs = nullptr;
+   Adapters const* adapters = nullptr;
+   std::shared_ptr<state> st = nullptr;
+   adapter_iterator adapter_iter{};
+   std::size_t index = 0;
+   std::size_t read_size = 0;
    boost::asio::coroutine coro{};
 
+   // The requests whose responses were not read fail with ec.
+   template <class Self>
+   void complete(Self& self, boost::system::error_code ec)
+   {
+      for (auto i = index; i < st->results.size(); ++i) {
+         if (!st->results[i].error)
+            st->results[i].error = ec;
+
+         conn->get_tracer().on_response_end(st->views[i], st->results[i].error, st->results[i].size);
+      }
+
+      if (ec)
+         conn->stats_.add(conn->stats_.requests_failed);
+      else
+         conn->stats_.add(conn->stats_.requests_completed);
+
+      auto results = std::move(st->results);
+      self.complete(ec, std::move(results));
+   }
+
    template <class Self>
    void
    operator()( Self& self
              , boost::system::error_code ec = {}
-             , std::size_t = 0)
+             , std::size_t n = 0)
    {
-      reenter (coro) for (;;)
+      reenter (coro)
       {
-         conn->ping_timer_.expires_after(conn->cfg_.ping_interval);
-         yield conn->ping_timer_.async_wait(std::move(self));
+         st = std::allocate_shared<state>(boost::asio::get_associated_allocator(self), conn->ex_);
+         st->views.assign(std::cbegin(*reqs), std::cend(*reqs));
+         st->results.resize(st->views.size());
+         if (st->results.empty()) {
+            yield boost::asio::post(conn->ex_, std::move(self));
+            self.complete({}, std::vector<exec_result>{});
+            return;
+         }
+
+         st->info.timer.expires_at(std::chrono::steady_clock::time_point::max());
+         st->info.req = st->views.front();
+         st->info.parts = st->views.data();
+         st->info.parts_size = st->views.size();
+         for (auto const& v: st->views) {
+            st->info.cmds += v.size();
+            st->info.bytes += v.payload().size() + v.external_size();
+         }
+         st->info.stop = false;
+
+         conn->add_request_info(std::shared_ptr<req_info_type>{st, &st->info});
+         yield st->info.timer.async_wait(std::move(self));
          BOOST_ASSERT(conn->socket_ != nullptr);
-         if (ec || !conn->socket_->is_open()) {
-            self.complete(ec);
+         BOOST_ASSERT(!!ec);
+         if (st->info.stop) {
+            complete(self, ec);
             return;
          }
 
-         conn->req_.clear();
-         conn->req_.push("PING");
-         conn->req_.close_on_run_completion = true;
-         yield conn->async_exec(conn->req_, aedis::adapt(), std::move(self));
-         if (ec) {
-            // Notice we don't report error but let the idle check
-            // timeout. It is enough to finish the op.
-            self.complete({});
+         BOOST_ASSERT(conn->socket_->lowest_layer().is_open());
+
+         if (st->info.cmds == 0) {
+            complete(self, {});
             return;
          }
+
+         BOOST_ASSERT(!conn->reqs_.empty());
+         BOOST_ASSERT(conn->reqs_.front() != nullptr);
+         BOOST_ASSERT(conn->cmds_ != 0);
+         conn->get_latency_recorder().on_first_byte(st->info.marks);
+
+         adapter_iter = std::cbegin(*adapters);
+         for (; index < st->views.size(); ++adapter_iter, ++index) {
+            conn->get_tracer().on_response_begin(st->views[index]);
+            if (st->views[index].size() != 0) {
+               yield conn->async_exec_read(*adapter_iter, st->views[index].size(), std::move(self));
+               st->results[index] = {ec, n};
+               if (ec) {
+                  complete(self, ec);
+                  return;
+               }
+            }
+
+            read_size += st->results[index].size;
+            conn->get_tracer().on_response_end(st->views[index], {}, st->results[index].size);
+         }
+
+         conn->stats_.add(conn->stats_.bytes_read, read_size);
+         conn->get_latency_recorder().on_parsed(st->info.marks);
+
+         BOOST_ASSERT(!conn->reqs_.empty());
+         conn->reqs_.pop_front();
+
+         if (conn->cmds_ == 0) {
+            conn->on_batch_complete();
+            conn->release_idle_buffers();
+            conn->read_timer_.cancel_one();
+            if (!conn->waiting_.empty())
+               conn->writer_timer_.cancel_one();
+         } else {
+            BOOST_ASSERT(!conn->reqs_.empty());
+            conn->reqs_.front()->timer.cancel_one();
+         }
+
+         complete(self, {});
       }
    }
 };
 
+// Runs the health checks every ping_interval, see
+// connection::check_health.
 template <class Conn>
-struct check_idle_op {
+struct ping_op {
    Conn* conn;
    boost::asio::coroutine coro{};
 
    template <class Self>
    void operator()(Self& self, boost::system::error_code ec = {})
    {
-      reenter (coro) for (;;)
+      reenter (coro)
       {
-         conn->check_idle_timer_.expires_after(2 * conn->cfg_.ping_interval);
-         yield conn->check_idle_timer_.async_wait(std::move(self));
-         BOOST_ASSERT(conn->socket_ != nullptr);
-         if (ec || !conn->socket_->is_open()) {
-            // Notice this is not an error, it was requested from an
-            // external op.
-            self.complete({});
+         if (conn->cfg_.wheel != nullptr) {
+            // The checks are run by the wheel, the timer is only
+            // waited on to be cancelled by cancel_run.
+            conn->cfg_.wheel->arm(conn->health_entry_, conn->cfg_.ping_interval);
+            conn->ping_timer_.expires_at(std::chrono::steady_clock::time_point::max());
+            yield conn->ping_timer_.async_wait(std::move(self));
+            self.complete(conn->health_ec_);
             return;
          }
 
-         auto const now = std::chrono::steady_clock::now();
-         if (conn->last_data_ +  (2 * conn->cfg_.ping_interval) < now) {
-            conn->cancel_run();
-            self.complete(error::idle_timeout);
-            return;
-         }
+         for (;;) {
+            conn->ping_timer_.expires_after(conn->cfg_.ping_interval);
+            yield conn->ping_timer_.async_wait(std::move(self));
+            BOOST_ASSERT(conn->socket_ != nullptr);
+            if (ec || !conn->socket_->lowest_layer().is_open()) {
+               // Notice this is not an error, it was requested from an
+               // external op.
+               self.complete({});
+               return;
+            }
 
-         conn->last_data_ = now;
+            if (!conn->check_health()) {
+               self.complete(conn->health_ec_);
+               return;
+            }
+         }
       }
    }
 };
@@ -339,24 +583,31 @@ struct start_op {
 
    template <class Self>
    void operator()( Self& self
-                  , std::array<std::size_t, 4> order = {}
+                  , std::array<std::size_t, 3> order = {}
                   , boost::system::error_code ec0 = {}
                   , boost::system::error_code ec1 = {}
-                  , boost::system::error_code ec2 = {}
-                  , boost::system::error_code ec3 = {})
+                  , boost::system::error_code ec2 = {})
    {
       reenter (coro)
       {
+         conn->health_ec_ = {};
+
          yield
          boost::asio::experimental::make_parallel_group(
             [this](auto token) { return conn->reader(token);},
             [this](auto token) { return conn->writer(token);},
-            [this](auto token) { return conn->async_check_idle(token);},
             [this](auto token) { return conn->async_ping(token);}
          ).async_wait(
             boost::asio::experimental::wait_for_one_error(),
             std::move(self));
 
+         // When the timer wheel closes a stalled connection the other
+         // ops may complete first.
+         if (conn->health_ec_) {
+            self.complete(conn->health_ec_);
+            return;
+         }
+
          switch (order[0]) {
            case 0:
            {
@@ -370,10 +621,6 @@ struct start_op {
            {
               self.complete(ec2);
            } break;
-           case 3:
-           {
-              self.complete(ec3);
-           } break;
            default: BOOST_ASSERT(false);
          }
       }
@@ -394,6 +641,7 @@ struct run_one_op {
       reenter (coro)
       {
          yield conn->async_resolve_with_timeout(std::move(self));
+         conn->get_tracer().on_resolve(ec);
          if (ec) {
             conn->cancel_run();
             self.complete(ec);
@@ -409,15 +657,35 @@ struct run_one_op {
             }
          }
 
-         conn->socket_ = std::make_shared<typename Conn::next_layer_type>(conn->resv_.get_executor());
+         conn->socket_ = conn->layer_.make_stream(conn->ex_);
 
          yield conn->async_connect_with_timeout(std::move(self));
+         conn->get_tracer().on_connect(ec);
          if (ec) {
+            // The cached addresses may be the reason, they are resolved
+            // again on the next attempt but kept in case the DNS
+            // server is unreachable meanwhile.
+            if (conn->cfg_.resolve_cache)
+               conn->cfg_.resolve_cache->mark_stale(conn->cfg_.host, conn->cfg_.port);
+
             conn->cancel_run();
             self.complete(ec);
             return;
          }
 
+         // Resolved again on reconnection.
+         conn->endpoints_ = {};
+
+         if (Conn::layer_type::requires_handshake) {
+            yield conn->async_handshake_with_timeout(std::move(self));
+            conn->get_tracer().on_handshake(ec);
+            if (ec) {
+               conn->cancel_run();
+               self.complete(ec);
+               return;
+            }
+         }
+
          if (conn->cfg_.enable_events) {
             conn->last_event_ = Conn::event::connect;
             yield async_send_receive(conn->push_channel_, std::move(self));
@@ -432,18 +700,23 @@ struct run_one_op {
             conn->req_.push("AUTH", conn->cfg_.username, conn->cfg_.password);
          conn->req_.push("HELLO", "3");
 
+         // Saves a round trip to users that would otherwise wait for
+         // the hello event to send them.
+         conn->req_.append(conn->cfg_.init);
+
          conn->ping_timer_.expires_after(conn->cfg_.ping_interval);
 
          yield
-         async_exec(
+         resp3::detail::async_exec(
             *conn->socket_,
             conn->ping_timer_,
             conn->req_,
-            adapter::adapt(),
+            error_adapter{},
             conn->make_dynamic_buffer(),
             std::move(self)
          );
 
+         conn->get_tracer().on_hello(ec);
          if (ec) {
             conn->cancel_run();
             self.complete(ec);
@@ -459,9 +732,11 @@ struct run_one_op {
             }
          }
 
-         std::for_each(std::begin(conn->reqs_), std::end(conn->reqs_), [](auto const& ptr) {
-            return ptr->written = false;
-         });
+         conn->reconnect_.reset();
+         conn->ping_pending_ = false;
+         conn->release_idle_buffers();
+
+         conn->requeue_requests();
 
          yield conn->async_start(std::move(self));
          self.complete(ec);
@@ -480,20 +755,49 @@ struct run_op {
       boost::system::error_code ec = {},
       std::size_t = 0)
    {
-      reenter (coro) for(;;)
+      reenter (coro)
       {
-         yield conn->async_run_one(std::move(self));
+         conn->reconnect_ =
+            reconnect_policy{
+               conn->cfg_.reconnect_interval,
+               conn->cfg_.max_reconnect_interval,
+               conn->cfg_.fast_first_reconnect};
+
+         conn->coalesce_ =
+            coalescing_policy{
+               conn->cfg_.max_coalesce_delay,
+               conn->cfg_.coalesce_bytes,
+               conn->cfg_.coalesce_commands};
+
+         for (;;) {
+            yield conn->async_run_one(std::move(self));
+
+            if (!conn->cfg_.enable_reconnect) {
+               self.complete(ec);
+               return;
+            }
 
-         if (!conn->cfg_.enable_reconnect) {
-            self.complete(ec);
-            return;
-         }
+            if (conn->reconnect_.attempts() == 0)
+               conn->reconnect_info_.disconnected_at = std::chrono::steady_clock::now();
 
-         // Consider communicating the return of async_run_one as an
-         // event here.
+            conn->reconnect_info_.error = ec;
+            conn->reconnect_info_.delay = conn->reconnect_.next();
+            conn->reconnect_info_.attempt = conn->reconnect_.attempts();
+            conn->stats_.add(conn->stats_.reconnects);
+            conn->get_tracer().on_reconnect(conn->reconnect_info_.attempt, conn->reconnect_info_.delay);
 
-         conn->ping_timer_.expires_after(conn->cfg_.reconnect_interval);
-         yield conn->ping_timer_.async_wait(std::move(self)); 
+            if (conn->cfg_.enable_events) {
+               conn->last_event_ = Conn::event::reconnect;
+               yield async_send_receive(conn->push_channel_, std::move(self));
+               if (ec) {
+                  self.complete(ec);
+                  return;
+               }
+            }
+
+            conn->ping_timer_.expires_after(conn->reconnect_info_.delay);
+            yield conn->ping_timer_.async_wait(std::move(self));
+         }
       }
    }
 };
@@ -509,26 +813,52 @@ struct writer_op {
                   , boost::system::error_code ec = {}
                   , std::size_t n = 0)
    {
-      boost::ignore_unused(n);
-
       reenter (coro) for (;;)
       {
-         while (!conn->reqs_.empty() && conn->cmds_ == 0 && conn->write_buffer_.empty()) {
+         while (!conn->waiting_.empty() && conn->cmds_ == 0 && conn->write_buffer_.empty()) {
+            if (conn->start_coalescing()) {
+               yield conn->writer_timer_.async_wait(std::move(self));
+               conn->stop_coalescing();
+               if (!conn->socket_->lowest_layer().is_open()) {
+                  self.complete({});
+                  return;
+               }
+
+               // All requests may have been canceled meanwhile.
+               if (conn->waiting_.empty())
+                  continue;
+            }
+
             conn->coalesce_requests();
-            yield boost::asio::async_write(*conn->socket_, boost::asio::buffer(conn->write_buffer_), std::move(self));
+            conn->last_write_ = std::chrono::steady_clock::now();
+
+            // Gather writes only when there are external arguments,
+            // the buffer sequence is copied by async_write.
+            if (conn->write_externals_.empty()) {
+               yield boost::asio::async_write(*conn->socket_, boost::asio::buffer(conn->write_buffer_), std::move(self));
+            } else {
+               yield boost::asio::async_write(*conn->socket_, conn->make_write_buffers(), std::move(self));
+            }
+
+            conn->get_tracer().on_write_end(ec, n);
             if (ec) {
                self.complete(ec);
                return;
             }
 
+            conn->stats_.add(conn->stats_.bytes_written, n);
+
             // We have to clear the payload right after the read op in
             // order to to use it as a flag that informs there is no
             // ongoing write.
+            conn->get_latency_recorder().on_write_complete(conn->reqs_);
             conn->write_buffer_.clear();
+            conn->write_externals_.clear();
+            conn->release_idle_buffers();
             conn->cancel_push_requests();
          }
 
-         if (conn->socket_->is_open()) {
+         if (conn->socket_->lowest_layer().is_open()) {
             yield conn->writer_timer_.async_wait(std::move(self));
             // The timer may be canceled either to stop the write op
             // or to proceed to the next write, the difference between
@@ -536,7 +866,7 @@ struct writer_op {
             // closed first. We check for that below.
          }
 
-         if (!conn->socket_->is_open()) {
+         if (!conn->socket_->lowest_layer().is_open()) {
             // Notice this is not an error of the op, stoping was
             // requested from the outside, so we complete with
             // success.
@@ -561,7 +891,7 @@ struct reader_op {
 
       reenter (coro) for (;;)
       {
-         BOOST_ASSERT(conn->socket_->is_open());
+         BOOST_ASSERT(conn->socket_->lowest_layer().is_open());
          yield boost::asio::async_read_until(*conn->socket_, conn->make_dynamic_buffer(), "\r\n", std::move(self));
          if (ec) {
             conn->cancel_run();
@@ -570,6 +900,7 @@ struct reader_op {
          }
 
          conn->last_data_ = std::chrono::steady_clock::now();
+         conn->stats_.update_max(conn->stats_.read_buffer_high_water, conn->read_buffer_.capacity());
 
          // We handle unsolicited events in the following way
          //
@@ -602,9 +933,10 @@ struct reader_op {
             BOOST_ASSERT(conn->cmds_ != 0);
             BOOST_ASSERT(!conn->reqs_.empty());
             BOOST_ASSERT(conn->reqs_.front()->cmds != 0);
+            conn->get_latency_recorder().on_first_byte(conn->reqs_.front()->marks);
             conn->reqs_.front()->timer.cancel_one();
             yield conn->read_timer_.async_wait(std::move(self));
-            if (!conn->socket_->is_open()) {
+            if (!conn->socket_->lowest_layer().is_open()) {
                self.complete({});
                return;
             }
@@ -614,10 +946,10 @@ struct reader_op {
    }
 };
 
-template <class Conn, class Adapter>
+template <class Conn, class Request, class Adapter>
 struct runexec_op {
    Conn* conn;
-   resp3::request const* req = nullptr;
+   Request const* req = nullptr;
    Adapter adapter;
    boost::asio::coroutine coro{};
 
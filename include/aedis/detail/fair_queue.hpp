@@ -0,0 +1,235 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_DETAIL_FAIR_QUEUE_HPP
+#define AEDIS_DETAIL_FAIR_QUEUE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <unordered_map>
+
+#include <boost/assert.hpp>
+#include <boost/circular_buffer.hpp>
+
+namespace aedis {
+namespace detail {
+
+/* Elements waiting to be written, with one FIFO per lane and tenant.
+ *
+ * Lanes are served in order, lane zero first. The tenants of a lane
+ * take turns in weighted round-robin: a tenant is served at most
+ * weight elements in a row, then the next tenant, tenants in the
+ * order they became non-empty. The round-robin cursor persists
+ * across calls.
+ *
+ * Tenants are never removed, only unlinked from the round-robin ring
+ * when their FIFO becomes empty, so their FIFO keeps its capacity and
+ * pushing and popping an element does not allocate once the tenant
+ * was seen. Both take constant time on average, independent of the
+ * number of elements and tenants queued.
+ */
+template <class T, std::size_t Lanes>
+class fair_queue {
+public:
+   bool empty() const noexcept { return size_ == 0; }
+   std::size_t size() const noexcept { return size_; }
+
+   // Appends v to the FIFO of the tenant in the lane.
+   void push_back(std::size_t lane, std::size_t tenant, std::size_t weight, T v)
+   {
+      BOOST_ASSERT(lane < Lanes);
+      auto& l = lanes_[lane];
+      auto const i = get(l, tenant, weight);
+      auto& elems = l.tenants[i].elems;
+      if (elems.full())
+         grow(elems);
+
+      elems.push_back(std::move(v));
+      ++size_;
+   }
+
+   // Inserts v before the elements of the tenant in the lane e.g. to
+   // write it again after a reconnection.
+   void push_front(std::size_t lane, std::size_t tenant, std::size_t weight, T v)
+   {
+      BOOST_ASSERT(lane < Lanes);
+      auto& l = lanes_[lane];
+      auto const i = get(l, tenant, weight);
+      auto& elems = l.tenants[i].elems;
+      if (elems.full())
+         grow(elems);
+
+      elems.push_front(std::move(v));
+      ++size_;
+   }
+
+   // The next element, must not be empty.
+   T const& front() const
+   {
+      auto const& l = next_lane();
+      return l.tenants[l.cursor].elems.front();
+   }
+
+   // Removes and returns the next element, must not be empty.
+   T pop()
+   {
+      auto& l = next_lane();
+      auto const i = l.cursor;
+      auto& q = l.tenants[i];
+      T ret = std::move(q.elems.front());
+      q.elems.pop_front();
+      --size_;
+
+      if (q.elems.empty()) {
+         unlink(l, i);
+      } else if (++l.served >= q.weight) {
+         l.served = 0;
+         l.cursor = q.next;
+      }
+
+      return ret;
+   }
+
+   // Calls f with each element, in no particular order.
+   template <class F>
+   void for_each(F f) const
+   {
+      for (auto const& l: lanes_) {
+         for (auto const& q: l.tenants) {
+            for (auto const& e: q.elems)
+               f(e);
+         }
+      }
+   }
+
+   // Removes the elements for which pred returns true, the order of
+   // the others is preserved. The cursor moves to the next tenant if
+   // the current one becomes empty.
+   template <class Pred>
+   void remove_if(Pred pred)
+   {
+      for (auto& l: lanes_) {
+         for (std::size_t i = 0; i < l.tenants.size(); ++i) {
+            auto& elems = l.tenants[i].elems;
+            if (elems.empty())
+               continue;
+
+            auto const point = std::remove_if(std::begin(elems), std::end(elems), pred);
+            auto const n = static_cast<std::size_t>(std::distance(point, std::end(elems)));
+            elems.erase_end(n);
+            size_ -= n;
+
+            if (elems.empty())
+               unlink(l, i);
+         }
+      }
+   }
+
+   // Releases the memory of all tenants.
+   void clear()
+   {
+      for (auto& l: lanes_)
+         l = {};
+
+      size_ = 0;
+   }
+
+private:
+   static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+   struct tenant_queue {
+      std::size_t weight = 1;
+      boost::circular_buffer<T> elems;
+      // Neighbours in the round-robin ring, valid when elems is not
+      // empty.
+      std::size_t prev = npos;
+      std::size_t next = npos;
+   };
+
+   struct lane {
+      // All tenants seen, indexed by the values of index.
+      std::vector<tenant_queue> tenants;
+      std::unordered_map<std::size_t, std::size_t> index;
+      // The tenant being served, npos when all are empty, and the
+      // elements it was served.
+      std::size_t cursor = npos;
+      std::size_t served = 0;
+   };
+
+   static void grow(boost::circular_buffer<T>& elems)
+   {
+      elems.set_capacity((std::max)(std::size_t{4}, 2 * elems.capacity()));
+   }
+
+   // Returns the position of the tenant, linking it into the ring
+   // before the cursor if it is empty.
+   static std::size_t get(lane& l, std::size_t tenant, std::size_t weight)
+   {
+      // Unlike find, emplace allocates even if the tenant exists.
+      auto pos = l.index.find(tenant);
+      if (pos == std::end(l.index)) {
+         pos = l.index.emplace(tenant, l.tenants.size()).first;
+         l.tenants.emplace_back();
+      }
+
+      auto const i = pos->second;
+      auto& q = l.tenants[i];
+      if (!q.elems.empty())
+         return i;
+
+      q.weight = (std::max)(std::size_t{1}, weight);
+      if (l.cursor == npos) {
+         q.prev = i;
+         q.next = i;
+         l.cursor = i;
+         l.served = 0;
+      } else {
+         auto const last = l.tenants[l.cursor].prev;
+         q.prev = last;
+         q.next = l.cursor;
+         l.tenants[last].next = i;
+         l.tenants[l.cursor].prev = i;
+      }
+
+      return i;
+   }
+
+   // Removes the tenant at i, which became empty, from the ring.
+   static void unlink(lane& l, std::size_t i)
+   {
+      auto& q = l.tenants[i];
+      if (l.cursor == i) {
+         l.cursor = q.next == i ? npos : q.next;
+         l.served = 0;
+      }
+
+      l.tenants[q.prev].next = q.next;
+      l.tenants[q.next].prev = q.prev;
+
+      q.prev = npos;
+      q.next = npos;
+   }
+
+   lane& next_lane()
+   {
+      BOOST_ASSERT(!empty());
+      return *std::find_if(std::begin(lanes_), std::end(lanes_), [](auto const& l) { return l.cursor != npos; });
+   }
+
+   lane const& next_lane() const
+      { return const_cast<fair_queue*>(this)->next_lane(); }
+
+   lane lanes_[Lanes];
+   std::size_t size_ = 0;
+};
+
+} // detail
+} // aedis
+
+#endif // AEDIS_DETAIL_FAIR_QUEUE_HPP
@@ -8,75 +8,253 @@
 #define AEDIS_NET_HPP
 
 #include <array>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <type_traits>
 
 #include <boost/system.hpp>
 #include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/connect.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/assert.hpp>
 #include <boost/asio/experimental/parallel_group.hpp>
 
+#include <aedis/error.hpp>
+
 namespace aedis {
 namespace detail {
 
+template <class Protocol>
+struct is_local_protocol : std::false_type {};
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+template <>
+struct is_local_protocol<boost::asio::local::stream_protocol> : std::true_type {};
+#endif // defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+
+/* Customization point for the next layer of the connection.
+ *
+ * Creates the stream on every (re)connection, performs the handshake
+ * after the connect operation and is notified right before the
+ * stream gets closed. The primary template handles plain sockets, see
+ * aedis/ssl/connection.hpp for TLS streams.
+ */
+template <class Stream>
+struct layer {
+   static constexpr bool requires_handshake = false;
+
+   template <class Executor>
+   std::shared_ptr<Stream> make_stream(Executor ex) const
+      { return std::make_shared<Stream>(ex); }
+
+   // Never called since requires_handshake is false.
+   template <class CompletionToken>
+   auto async_handshake(Stream& stream, std::string const&, CompletionToken&& token)
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code)
+         >([](auto& self) { self.complete({}); }, token, stream);
+   }
+
+   void on_close(Stream&) noexcept {}
+};
+
+// Returns true if host is an IP address and port a number, in which
+// case no resolution is needed. IPv6 addresses may be in brackets as
+// in URLs, e.g. [::1].
+inline bool
+make_literal_endpoint(
+   std::string const& host,
+   std::string const& port,
+   boost::asio::ip::tcp::endpoint& ep)
+{
+   boost::string_view addr_str{host};
+   if (addr_str.size() > 2 && addr_str.front() == '[' && addr_str.back() == ']') {
+      addr_str.remove_prefix(1);
+      addr_str.remove_suffix(1);
+   }
+
+   boost::system::error_code ec;
+   auto const addr = boost::asio::ip::make_address(std::string{addr_str}, ec);
+   if (ec || port.empty() || port.size() > 5)
+      return false;
+
+   unsigned long n = 0;
+   for (auto c: port) {
+      if (c < '0' || c > '9')
+         return false;
+      n = 10 * n + static_cast<unsigned long>(c - '0');
+   }
+
+   if (n > 65535)
+      return false;
+
+   ep = boost::asio::ip::tcp::endpoint{addr, static_cast<unsigned short>(n)};
+   return true;
+}
+
+// Alternates IPv6 and IPv4 addresses starting with the family of the
+// first one, as recommended by RFC 8305.
+inline std::vector<boost::asio::ip::tcp::endpoint>
+interleave_families(boost::asio::ip::tcp::resolver::results_type const& res)
+{
+   std::vector<boost::asio::ip::tcp::endpoint> first, second, ret;
+   for (auto const& e: res) {
+      auto const& ep = e.endpoint();
+      if (first.empty() || ep.protocol() == first.front().protocol())
+         first.push_back(ep);
+      else
+         second.push_back(ep);
+   }
+
+   for (std::size_t i = 0; i < first.size() || i < second.size(); ++i) {
+      if (i < first.size())
+         ret.push_back(first[i]);
+      if (i < second.size())
+         ret.push_back(second[i]);
+   }
+
+   return ret;
+}
+
 template <class Executor>
 using conn_timer_t = boost::asio::basic_waitable_timer<std::chrono::steady_clock, boost::asio::wait_traits<std::chrono::steady_clock>, Executor>;
 
 #include <boost/asio/yield.hpp>
 
-template <
-   class Protocol,
-   class Executor,
-   class EndpointSequence
-   >
-struct connect_op {
+// Connects to the endpoints as described in RFC 8305 (happy
+// eyeballs): a new attempt is started every delay or as soon as the
+// previous one fails, the first attempt to succeed wins and the
+// others are closed. The timer bounds the whole operation.
+template <class Protocol, class Executor, class Self>
+struct connect_state
+   : std::enable_shared_from_this<connect_state<Protocol, Executor, Self>> {
+   using socket_type = boost::asio::basic_stream_socket<Protocol, Executor>;
+   using endpoint_type = typename Protocol::endpoint;
+
+   Self self;
    boost::asio::basic_socket<Protocol, Executor>* socket;
    conn_timer_t<Executor>* timer;
-   EndpointSequence* endpoints;
-   boost::asio::coroutine coro{};
+   std::vector<endpoint_type> const* endpoints;
+   std::chrono::milliseconds delay;
+   conn_timer_t<Executor> delay_timer;
+   std::vector<std::unique_ptr<socket_type>> attempts;
+   std::size_t pending = 0;
+   boost::system::error_code last_error = boost::asio::error::host_not_found;
+   bool done = false;
 
-   template <class Self>
-   void operator()( Self& self
-                  , std::array<std::size_t, 2> order = {}
-                  , boost::system::error_code ec1 = {}
-                  , typename Protocol::endpoint const& ep = {}
-                  , boost::system::error_code ec2 = {})
+   connect_state(
+      Self s,
+      boost::asio::basic_socket<Protocol, Executor>* sock,
+      conn_timer_t<Executor>* t,
+      std::vector<endpoint_type> const* eps,
+      std::chrono::milliseconds d)
+   : self{std::move(s)}
+   , socket{sock}
+   , timer{t}
+   , endpoints{eps}
+   , delay{d}
+   , delay_timer{sock->get_executor()}
+   { }
+
+   void start()
    {
-      reenter (coro)
-      {
-         yield
-         boost::asio::experimental::make_parallel_group(
-            [this](auto token)
-            {
-               auto f = [](boost::system::error_code const&, typename Protocol::endpoint const&) { return true; };
-               return boost::asio::async_connect(*socket, *endpoints, f, token);
-            },
-            [this](auto token) { return timer->async_wait(token);}
-         ).async_wait(
-            boost::asio::experimental::wait_for_one(),
-            std::move(self));
+      timer->async_wait([s = this->shared_from_this()](boost::system::error_code ec) {
+         // Not aborted by finish means aborted from the outside.
+         s->finish(ec ? ec : error::connect_timeout);
+      });
 
-         switch (order[0]) {
-            case 0:
-            {
-               if (ec1) {
-                  self.complete(ec1, ep);
-                  return;
-               }
-            } break;
+      if (endpoints->empty()) {
+         boost::asio::post(delay_timer.get_executor(), [s = this->shared_from_this()]() {
+            s->finish(boost::asio::error::host_not_found);
+         });
+         return;
+      }
 
-            case 1:
-            {
-               if (!ec2) {
-                  self.complete(error::connect_timeout, ep);
-                  return;
-               }
-            } break;
+      start_next();
+   }
 
-            default: BOOST_ASSERT(false);
-         }
+   void start_next()
+   {
+      if (done)
+         return;
+
+      auto const i = attempts.size();
+      if (i == endpoints->size()) {
+         if (pending == 0)
+            finish(last_error);
+         return;
+      }
+
+      attempts.push_back(std::make_unique<socket_type>(socket->get_executor()));
+      ++pending;
+      attempts.back()->async_connect(endpoints->at(i),
+         [s = this->shared_from_this(), i](boost::system::error_code ec) {
+            s->on_connect(ec, i);
+         });
+
+      if (i + 1 < endpoints->size()) {
+         delay_timer.expires_after(delay);
+         delay_timer.async_wait([s = this->shared_from_this()](boost::system::error_code ec) {
+            if (!ec)
+               s->start_next();
+         });
+      }
+   }
+
+   void on_connect(boost::system::error_code ec, std::size_t i)
+   {
+      --pending;
+      if (done)
+         return;
 
-         self.complete({}, ep);
+      if (ec) {
+         // Does not wait for the delay to try the next endpoint.
+         last_error = ec;
+         delay_timer.cancel();
+         start_next();
+         return;
       }
+
+      *socket = std::move(*attempts.at(i));
+      finish({});
+   }
+
+   void finish(boost::system::error_code ec)
+   {
+      if (done)
+         return;
+
+      done = true;
+      timer->cancel();
+      delay_timer.cancel();
+
+      boost::system::error_code ignore;
+      for (auto& a: attempts)
+         a->close(ignore);
+
+      self.complete(ec);
+   }
+};
+
+template <class Protocol, class Executor>
+struct connect_op {
+   boost::asio::basic_socket<Protocol, Executor>* socket;
+   conn_timer_t<Executor>* timer;
+   std::vector<typename Protocol::endpoint> const* endpoints;
+   std::chrono::milliseconds delay;
+
+   template <class Self>
+   void operator()(Self& self)
+   {
+      std::make_shared<connect_state<Protocol, Executor, Self>>(
+         std::move(self), socket, timer, endpoints, delay)->start();
    }
 };
 
@@ -159,20 +337,20 @@ struct send_receive_op {
 template <
    class Protocol,
    class Executor,
-   class EndpointSequence,
    class CompletionToken = boost::asio::default_completion_token_t<Executor>
    >
 auto async_connect(
       boost::asio::basic_socket<Protocol, Executor>& socket,
       conn_timer_t<Executor>& timer,
-      EndpointSequence ep,
+      std::vector<typename Protocol::endpoint> const& endpoints,
+      std::chrono::milliseconds delay,
       CompletionToken&& token = boost::asio::default_completion_token_t<Executor>{})
 {
    return boost::asio::async_compose
       < CompletionToken
-      , void(boost::system::error_code, typename Protocol::endpoint const&)
-      >(connect_op<Protocol, Executor, EndpointSequence>
-            {&socket, &timer, &ep}, token, socket, timer);
+      , void(boost::system::error_code)
+      >(connect_op<Protocol, Executor>
+            {&socket, &timer, &endpoints, delay}, token, socket, timer);
 }
 
 template <
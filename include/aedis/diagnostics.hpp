@@ -0,0 +1,305 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_DIAGNOSTICS_HPP
+#define AEDIS_DIAGNOSTICS_HPP
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+#include <boost/system/error_code.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/resp3/request.hpp>
+
+namespace aedis {
+
+/** \brief A request whose latency exceeded the threshold of a slow_log.
+ *  \ingroup any
+ */
+struct slow_request {
+   /// The name of the first command of the request.
+   std::string command;
+
+   /// The arguments of the first command, truncated.
+   std::string args;
+
+   /// The number of commands in the request.
+   std::size_t commands = 0;
+
+   /// The size of the request payload.
+   std::size_t request_bytes = 0;
+
+   /// The size of the responses.
+   std::size_t response_bytes = 0;
+
+   /// Time between async_exec and the start of the write.
+   std::chrono::microseconds queue{0};
+
+   /// Time between async_exec and its completion.
+   std::chrono::microseconds total{0};
+
+   /// When the request completed.
+   std::chrono::system_clock::time_point when;
+
+   /// The error the request completed with.
+   boost::system::error_code error;
+};
+
+/** \brief Keeps the last requests that were slower than a threshold.
+ *  \ingroup any
+ *
+ *  Fed by diagnostics_tracer. Only slow requests take the lock, so
+ *  it is cheap enough to be left on. This class is thread safe.
+ */
+class slow_log {
+public:
+   /** \brief Constructor.
+    *
+    *  \param threshold Requests that take longer than this are logged.
+    *  \param capacity Number of requests kept, older ones are dropped.
+    *  \param max_args_size The arguments are truncated to this size.
+    */
+   explicit
+   slow_log(
+      std::chrono::microseconds threshold = std::chrono::milliseconds{10},
+      std::size_t capacity = 128,
+      std::size_t max_args_size = 64);
+
+   /// Returns the threshold.
+   std::chrono::microseconds threshold() const noexcept { return threshold_; }
+
+   /// Returns the maximum size of the arguments.
+   std::size_t max_args_size() const noexcept { return max_args_size_; }
+
+   /// Adds a request, dropping the oldest one when full.
+   void add(slow_request req);
+
+   /// Returns the requests kept, oldest first.
+   std::vector<slow_request> entries() const;
+
+   /// Returns the number of requests added, including dropped ones.
+   std::uint64_t total() const;
+
+   /// Removes all requests.
+   void clear();
+
+private:
+   mutable std::mutex mutex_;
+   std::chrono::microseconds threshold_;
+   std::size_t capacity_;
+   std::size_t max_args_size_;
+   std::vector<slow_request> ring_;
+   std::uint64_t total_ = 0;
+};
+
+/** \brief Estimates the most frequently used keys.
+ *  \ingroup any
+ *
+ *  Uses the space-saving algorithm: a fixed number of counters is
+ *  kept and a key that is not being counted replaces the one with
+ *  the smallest count, inheriting it as the error of the estimate.
+ *  Every key whose frequency is above 1/capacity of the samples is
+ *  guaranteed to be counted.
+ *
+ *  Only one in \c sample_rate requests is inspected, counts are
+ *  scaled back by that rate. The key of a command is taken to be its
+ *  first argument, commands without keys are skipped. This class is
+ *  thread safe, requests that are not sampled only increment an
+ *  atomic counter.
+ */
+class hot_keys {
+public:
+   /// A counted key.
+   struct entry {
+      /// The key.
+      std::string key;
+      /// Estimated number of uses, never smaller than the real one.
+      std::uint64_t count = 0;
+      /// Maximum overestimation of count.
+      std::uint64_t error = 0;
+   };
+
+   /** \brief Constructor.
+    *
+    *  \param capacity The number of keys counted.
+    *  \param sample_rate One in this many requests is inspected.
+    */
+   explicit hot_keys(std::size_t capacity = 64, std::size_t sample_rate = 16);
+
+   /// Inspects the commands of a request if it is sampled.
+   void sample(resp3::request_view const& req);
+
+   /// Counts a key as used \c n times, bypassing the sampling.
+   void add(boost::string_view key, std::uint64_t n = 1);
+
+   /// Returns the \c n keys with the largest counts, in decreasing order.
+   std::vector<entry> top(std::size_t n) const;
+
+   /// Removes all keys.
+   void clear();
+
+private:
+   void add_locked(boost::string_view key, std::uint64_t n);
+
+   mutable std::mutex mutex_;
+   std::size_t capacity_;
+   std::size_t sample_rate_;
+   std::atomic<std::size_t> calls_{0};
+   std::vector<entry> entries_;
+   std::unordered_map<std::string, std::size_t> index_;
+};
+
+/** \brief A connection tracer that feeds a slow_log and hot_keys.
+ *  \ingroup any
+ *
+ *  For example
+ *
+ *  @code
+ *  using connection = aedis::connection<tcp::socket, aedis::diagnostics_tracer>;
+ *  auto log = std::make_shared<aedis::slow_log>(std::chrono::milliseconds{5});
+ *  db.get_tracer().set_slow_log(log);
+ *  @endcode
+ *
+ *  Both can be shared by many connections. When neither is set the
+ *  tracer does nothing. Requests that cannot be recorded because an
+ *  allocation fails are dropped.
+ */
+class diagnostics_tracer {
+public:
+   /// Sets the slow log, may be null.
+   void set_slow_log(std::shared_ptr<slow_log> log) noexcept
+      { log_ = std::move(log); }
+
+   /// Sets the hot key counter, may be null.
+   void set_hot_keys(std::shared_ptr<hot_keys> keys) noexcept
+      { keys_ = std::move(keys); }
+
+   /// \cond
+   void on_exec(resp3::request_view const& req) noexcept;
+   void on_write_begin(resp3::request_view const& req, std::size_t size) noexcept;
+   void on_write_end(boost::system::error_code, std::size_t) noexcept {}
+   void on_response_begin(resp3::request_view const&) noexcept {}
+   void on_response_end(resp3::request_view const& req, boost::system::error_code ec, std::size_t size) noexcept;
+   void on_resolve(boost::system::error_code) noexcept {}
+   void on_connect(boost::system::error_code) noexcept {}
+   void on_handshake(boost::system::error_code) noexcept {}
+   void on_hello(boost::system::error_code) noexcept {}
+   void on_reconnect(std::size_t, std::chrono::milliseconds) noexcept {}
+   /// \endcond
+
+private:
+   using clock_type = std::chrono::steady_clock;
+
+   struct pending {
+      clock_type::time_point exec;
+      clock_type::time_point write;
+   };
+
+   // Pending requests by request_view::id, requests are written in
+   // lane order and not in the order of async_exec.
+   using pending_map = std::unordered_map<void const*, pending>;
+
+   // Nodes of completed requests, reused to avoid allocating on
+   // every request.
+   static constexpr std::size_t max_spare_nodes = 64;
+
+   std::shared_ptr<slow_log> log_;
+   std::shared_ptr<hot_keys> keys_;
+   pending_map pending_;
+   std::vector<pending_map::node_type> spare_;
+};
+
+namespace detail {
+
+// The first bulk strings of a command in a request payload.
+struct command_view {
+   static constexpr std::size_t max_args = 8;
+
+   // The number of bulk strings in the command, including its name.
+   std::size_t size = 0;
+   std::array<boost::string_view, max_args> args;
+};
+
+/* Calls f with a command_view for every command in the payload.
+ * Externals are the external arguments of the request, which are not
+ * in the payload, see resp3::request::externals.
+ */
+template <class Externals, class Function>
+void for_each_command(boost::string_view payload, Externals const& externals, Function f)
+{
+   auto const total = payload.size();
+   auto ext = std::cbegin(externals);
+   auto const read_number = [&payload](char prefix, std::size_t& n) {
+      if (payload.empty() || payload.front() != prefix)
+         return false;
+
+      auto const pos = payload.find("\r\n");
+      if (pos == boost::string_view::npos)
+         return false;
+
+      n = 0;
+      for (auto c: payload.substr(1, pos - 1)) {
+         if (c < '0' || c > '9')
+            return false;
+         n = 10 * n + static_cast<std::size_t>(c - '0');
+      }
+
+      payload.remove_prefix(pos + 2);
+      return true;
+   };
+
+   while (!payload.empty()) {
+      command_view cmd;
+      if (!read_number('*', cmd.size))
+         return;
+
+      for (std::size_t i = 0; i < cmd.size; ++i) {
+         std::size_t len = 0;
+         if (!read_number('$', len))
+            return;
+
+         boost::string_view arg;
+         if (ext != std::cend(externals) && ext->offset == total - payload.size()) {
+            arg = {static_cast<char const*>(ext->arg.data.data()), ext->arg.data.size()};
+            len = 0;
+            ++ext;
+         } else {
+            if (payload.size() < len + 2)
+               return;
+
+            arg = payload.substr(0, len);
+         }
+
+         if (i < command_view::max_args)
+            cmd.args[i] = arg;
+
+         payload.remove_prefix(len + 2);
+      }
+
+      f(cmd);
+   }
+}
+
+template <class Function>
+void for_each_command(boost::string_view payload, Function f)
+{
+   std::array<resp3::external_segment, 0> const none{};
+   for_each_command(payload, none, f);
+}
+
+} // detail
+} // aedis
+
+#endif // AEDIS_DIAGNOSTICS_HPP
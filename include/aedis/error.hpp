@@ -71,7 +71,10 @@ enum class error
    not_a_double,
 
    /// Got RESP3 null type.
-   null
+   null,
+
+   /// TLS handshake timeout.
+   handshake_timeout
 };
 
 /** \internal
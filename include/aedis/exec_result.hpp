@@ -0,0 +1,29 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_EXEC_RESULT_HPP
+#define AEDIS_EXEC_RESULT_HPP
+
+#include <cstddef>
+
+#include <boost/system/error_code.hpp>
+
+namespace aedis {
+
+/** \brief The result of a request executed with connection::async_exec_batch.
+ *  \ingroup any
+ */
+struct exec_result {
+   /// The error the request completed with.
+   boost::system::error_code error;
+
+   /// The size of the responses in bytes.
+   std::size_t size = 0;
+};
+
+} // aedis
+
+#endif // AEDIS_EXEC_RESULT_HPP
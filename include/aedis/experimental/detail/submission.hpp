@@ -0,0 +1,130 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_EXPERIMENTAL_DETAIL_SUBMISSION_HPP
+#define AEDIS_EXPERIMENTAL_DETAIL_SUBMISSION_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace aedis {
+namespace experimental {
+namespace detail {
+
+/* Blocks a thread until another thread calls notify, at most once.
+ * The object is meant to live on the stack of the waiting thread and
+ * can be destroyed as soon as wait returns. On Linux it is a futex,
+ * elsewhere a mutex and a condition variable.
+ */
+class waiter {
+public:
+   void wait() noexcept
+   {
+#if defined(__linux__)
+      // Responses often arrive within a few microseconds.
+      for (int i = 0; i < 128; ++i) {
+         if (state_.load(std::memory_order_acquire) != 0)
+            return;
+      }
+
+      while (state_.load(std::memory_order_acquire) == 0)
+         futex(FUTEX_WAIT_PRIVATE, 0);
+#else
+      std::unique_lock<std::mutex> lk{mutex_};
+      cv_.wait(lk, [this]() { return ready_; });
+#endif
+   }
+
+   void notify() noexcept
+   {
+#if defined(__linux__)
+      state_.store(1, std::memory_order_release);
+      // The waiter may have returned and this object be gone by now,
+      // a wake on a stale address is harmless as futex waiters check
+      // their condition again.
+      futex(FUTEX_WAKE_PRIVATE, 1);
+#else
+      // Notifies under the lock so that the waiter can't return and
+      // destroy the object meanwhile.
+      std::lock_guard<std::mutex> lk{mutex_};
+      ready_ = true;
+      cv_.notify_one();
+#endif
+   }
+
+private:
+#if defined(__linux__)
+   static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex requires a 32 bit word");
+
+   void futex(int op, std::uint32_t val) noexcept
+   {
+      ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&state_), op, val, nullptr, nullptr, 0);
+   }
+
+   std::atomic<std::uint32_t> state_{0};
+#else
+   std::mutex mutex_;
+   std::condition_variable cv_;
+   bool ready_ = false;
+#endif
+};
+
+// An element of the submission_queue, owned by the submitter.
+struct submission {
+   submission* next = nullptr;
+};
+
+/* An intrusive multi-producer single-consumer queue. Producers push
+ * with a compare-and-swap, the consumer takes all elements at once.
+ * push returns true when the queue was empty, i.e. exactly once per
+ * batch, which is when the consumer has to be woken up.
+ */
+class submission_queue {
+public:
+   bool push(submission* s) noexcept
+   {
+      auto* head = head_.load(std::memory_order_relaxed);
+      do {
+         s->next = head;
+      } while (!head_.compare_exchange_weak(head, s, std::memory_order_release, std::memory_order_relaxed));
+
+      return head == nullptr;
+   }
+
+   // Returns the elements in the order they were pushed.
+   submission* pop_all() noexcept
+   {
+      auto* head = head_.exchange(nullptr, std::memory_order_acquire);
+
+      submission* prev = nullptr;
+      while (head != nullptr) {
+         auto* next = head->next;
+         head->next = prev;
+         prev = head;
+         head = next;
+      }
+
+      return prev;
+   }
+
+private:
+   std::atomic<submission*> head_{nullptr};
+};
+
+} // detail
+} // experimental
+} // aedis
+
+#endif // AEDIS_EXPERIMENTAL_DETAIL_SUBMISSION_HPP
@@ -0,0 +1,391 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_EXPERIMENTAL_HUB_HPP
+#define AEDIS_EXPERIMENTAL_HUB_HPP
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <array>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+#include <boost/assert.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/adapt.hpp>
+#include <aedis/hash_slot.hpp>
+#include <aedis/resp3/node.hpp>
+#include <aedis/resp3/request.hpp>
+
+namespace aedis {
+namespace experimental {
+
+/** @brief A message published on a channel.
+ *  @ingroup any
+ *
+ *  Messages are delivered to listeners as a pointer to an immutable
+ *  object that is shared among all listeners of the channel.
+ */
+struct message {
+   /// The channel the message was published on.
+   std::string channel;
+
+   /// The message payload.
+   std::string payload;
+};
+
+namespace detail {
+
+#include <boost/asio/yield.hpp>
+
+template <class Hub>
+struct hub_receive_op {
+   using event_type = typename Hub::event_type;
+
+   Hub* hub;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void operator()( Self& self
+                  , boost::system::error_code ec = {}
+                  , event_type ev = event_type::invalid)
+   {
+      reenter (coro) for (;;)
+      {
+         yield hub->conn_->async_receive_event(aedis::adapt(hub->resp_), std::move(self));
+         if (ec) {
+            self.complete(ec);
+            return;
+         }
+
+         switch (ev) {
+            case event_type::push: hub->deliver(); break;
+            case event_type::hello: hub->on_hello(); break;
+            case event_type::reconnect:
+            case event_type::resolve:
+            case event_type::connect: hub->on_disconnect(); break;
+            default:;
+         }
+
+         hub->resp_.clear();
+      }
+   }
+};
+
+#include <boost/asio/unyield.hpp>
+
+} // detail
+
+/** @brief Shares Redis subscriptions among many local listeners.
+ *  @ingroup any
+ *
+ *  The hub keeps a single \c SUBSCRIBE per channel on the connection
+ *  regardless of how many local listeners are interested in it. The
+ *  first listener of a channel causes the hub to subscribe to it and
+ *  the last one to leave causes it to unsubscribe. Each message is
+ *  read once and delivered to every listener as a shared immutable
+ *  object, posted to the executor the listener was registered with.
+ *
+ *  Sharded channels (Redis 7) are supported with \c ssubscribe and
+ *  \c sunsubscribe. Since all channels of a \c SSUBSCRIBE must
+ *  belong to the same hash slot, the hub groups them by slot when
+ *  subscribing. The hub does not route channels to cluster nodes, its
+ *  connection must be to the node that owns their slots, see
+ *  hash_slot. When the server unsubscribes a sharded channel on its
+ *  own, e.g. because its slot was migrated to another node, the
+ *  channel is removed from the hub and the handler set with \c
+ *  set_sunsubscribe_handler is called, so that the application can
+ *  subscribe again on a connection to the new owner.
+ *
+ *  The hub consumes the events of the connection, users must not
+ *  call \c async_receive_event themselves. Subscriptions are renewed
+ *  on reconnection, for that to work the connection must have
+ *  connection::config::enable_events set.
+ *
+ *  The functions \c subscribe, \c unsubscribe, \c ssubscribe and \c
+ *  sunsubscribe are thread safe.
+ */
+template <class Connection>
+class hub {
+public:
+   /// The type of the connection.
+   using connection_type = Connection;
+
+   /// The type of the message delivered to listeners.
+   using message_ptr = std::shared_ptr<message const>;
+
+   /// The type of the listener callback.
+   using handler_type = std::function<void(message_ptr)>;
+
+   /** @brief Constructor.
+    *
+    *  \param conn The connection used to subscribe.
+    */
+   explicit hub(std::shared_ptr<Connection> conn)
+   : conn_{std::move(conn)}
+   {}
+
+   /** @brief Receives events from the connection and delivers them.
+    *
+    *  This function must be called once and completes only when
+    *  \c async_receive_event completes with an error e.g. after \c
+    *  connection::cancel_event_receiver. The completion token must
+    *  have the following signature
+    *
+    *  @code
+    *  void f(boost::system::error_code);
+    *  @endcode
+    */
+   template <class CompletionToken = typename Connection::default_completion_token_type>
+   auto async_receive(CompletionToken token = CompletionToken{})
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code)
+         >(detail::hub_receive_op<hub>{this}, token, conn_->get_executor());
+   }
+
+   /** @brief Adds a listener to a channel.
+    *
+    *  \param channel The channel.
+    *  \param ex The executor on which \c h will be called.
+    *  \param h The callback called with every message published on
+    *  the channel.
+    *  \returns The listener id, to be passed to \c unsubscribe.
+    */
+   std::size_t
+   subscribe(std::string const& channel, boost::asio::any_io_executor ex, handler_type h)
+      { return add(kind::global, channel, ex, std::move(h)); }
+
+   /** @brief Removes a listener from a channel.
+    *
+    *  \param channel The channel passed to \c subscribe.
+    *  \param id The id returned by \c subscribe.
+    */
+   void unsubscribe(std::string const& channel, std::size_t id)
+      { remove(kind::global, channel, id); }
+
+   /** @brief Adds a listener to a sharded channel.
+    *
+    *  Same as \c subscribe but for channels published with \c
+    *  SPUBLISH.
+    */
+   std::size_t
+   ssubscribe(std::string const& channel, boost::asio::any_io_executor ex, handler_type h)
+      { return add(kind::sharded, channel, ex, std::move(h)); }
+
+   /** @brief Removes a listener from a sharded channel.
+    *
+    *  \param channel The channel passed to \c ssubscribe.
+    *  \param id The id returned by \c ssubscribe.
+    */
+   void sunsubscribe(std::string const& channel, std::size_t id)
+      { remove(kind::sharded, channel, id); }
+
+   /** @brief Sets the handler of sharded channels dropped by the server.
+    *
+    *  Called on \c ex with the name of a sharded channel that the
+    *  server unsubscribed without being asked to, after its listeners
+    *  were removed. Subscribing again on the same node would fail with
+    *  \c -MOVED after a slot migration.
+    */
+   void
+   set_sunsubscribe_handler(
+      boost::asio::any_io_executor ex,
+      std::function<void(std::string const&)> h)
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      sunsubscribe_ex_ = ex;
+      sunsubscribe_handler_ = std::move(h);
+   }
+
+   /// Returns the number of channels the hub is subscribed to.
+   std::size_t channels() const
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      return channels_[kind::global].size() + channels_[kind::sharded].size();
+   }
+
+private:
+   using event_type = typename Connection::event;
+
+   template <class T> friend struct detail::hub_receive_op;
+
+   struct listener {
+      std::size_t id;
+      boost::asio::any_io_executor ex;
+      handler_type handler;
+   };
+
+   using listener_ptr = std::shared_ptr<listener const>;
+   using channels_type = std::map<std::string, std::vector<listener_ptr>>;
+
+   enum kind { global, sharded };
+
+   static constexpr char const* subscribe_cmds[] = {"SUBSCRIBE", "SSUBSCRIBE"};
+   static constexpr char const* unsubscribe_cmds[] = {"UNSUBSCRIBE", "SUNSUBSCRIBE"};
+
+   std::size_t
+   add(kind k, std::string const& channel, boost::asio::any_io_executor ex, handler_type h)
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      auto const id = ++last_id_;
+      auto& listeners = channels_[k][channel];
+      listeners.push_back(std::make_shared<listener const>(listener{id, ex, std::move(h)}));
+      if (listeners.size() == 1)
+         send(subscribe_cmds[k], channel);
+
+      return id;
+   }
+
+   void remove(kind k, std::string const& channel, std::size_t id)
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      auto iter = channels_[k].find(channel);
+      if (iter == std::end(channels_[k]))
+         return;
+
+      auto& listeners = iter->second;
+      listeners.erase(
+         std::remove_if(std::begin(listeners), std::end(listeners),
+            [id](auto const& l) { return l->id == id; }),
+         std::end(listeners));
+
+      if (listeners.empty()) {
+         channels_[k].erase(iter);
+         if (k == kind::sharded && connected_)
+            ++pending_sunsubscribes_[channel];
+
+         send(unsubscribe_cmds[k], channel);
+      }
+   }
+
+   // Must be called with the mutex locked.
+   void send(char const* cmd, std::string const& channel)
+   {
+      if (!connected_)
+         return; // Will be sent on the hello event.
+
+      auto req = std::make_shared<resp3::request>();
+      req->push(cmd, channel);
+      boost::asio::dispatch(conn_->get_executor(), [conn = conn_, req]() {
+         conn->async_exec(*req, aedis::adapt(), [req](auto, auto) {});
+      });
+   }
+
+   void on_hello()
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      connected_ = true;
+
+      auto req = std::make_shared<resp3::request>();
+
+      if (!channels_[kind::global].empty()) {
+         std::vector<boost::string_view> channels;
+         for (auto const& e: channels_[kind::global])
+            channels.push_back(e.first);
+
+         req->push_range("SUBSCRIBE", channels);
+      }
+
+      // All channels in a SSUBSCRIBE must hash to the same slot.
+      std::map<std::size_t, std::vector<boost::string_view>> slots;
+      for (auto const& e: channels_[kind::sharded])
+         slots[hash_slot(e.first)].push_back(e.first);
+
+      for (auto const& e: slots)
+         req->push_range("SSUBSCRIBE", e.second);
+
+      lk.unlock();
+
+      if (!std::empty(req->payload()))
+         conn_->async_exec(*req, aedis::adapt(), [req](auto, auto) {});
+   }
+
+   void on_disconnect()
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+      connected_ = false;
+      pending_sunsubscribes_.clear();
+   }
+
+   void on_sunsubscribe(std::string const& channel)
+   {
+      std::unique_lock<std::mutex> lk{mutex_};
+
+      // Confirms a SUNSUBSCRIBE sent by the hub.
+      auto pending = pending_sunsubscribes_.find(channel);
+      if (pending != std::end(pending_sunsubscribes_)) {
+         if (--pending->second == 0)
+            pending_sunsubscribes_.erase(pending);
+         return;
+      }
+
+      if (channels_[kind::sharded].erase(channel) == 0 || !sunsubscribe_handler_)
+         return;
+
+      boost::asio::post(sunsubscribe_ex_, [h = sunsubscribe_handler_, channel]() { h(channel); });
+   }
+
+   void deliver()
+   {
+      // Pushes have the form [type, channel, payload-or-count].
+      if (std::size(resp_) != 4)
+         return;
+
+      auto const& type = resp_.at(1).value;
+
+      if (type == "sunsubscribe") {
+         on_sunsubscribe(resp_.at(2).value);
+         return;
+      }
+
+      kind k;
+      if (type == "message")
+         k = kind::global;
+      else if (type == "smessage")
+         k = kind::sharded;
+      else
+         return;
+
+      auto msg = std::make_shared<message>();
+      msg->channel = std::move(resp_.at(2).value);
+      msg->payload = std::move(resp_.at(3).value);
+      message_ptr const cmsg = std::move(msg);
+
+      std::unique_lock<std::mutex> lk{mutex_};
+      auto iter = channels_[k].find(cmsg->channel);
+      if (iter == std::end(channels_[k]))
+         return;
+
+      for (auto const& l: iter->second)
+         boost::asio::post(l->ex, [l, cmsg]() { l->handler(cmsg); });
+   }
+
+   std::shared_ptr<Connection> conn_;
+   mutable std::mutex mutex_;
+   std::array<channels_type, 2> channels_;
+   std::size_t last_id_ = 0;
+   bool connected_ = false;
+   std::map<std::string, std::size_t> pending_sunsubscribes_;
+   boost::asio::any_io_executor sunsubscribe_ex_;
+   std::function<void(std::string const&)> sunsubscribe_handler_;
+   std::vector<resp3::node<std::string>> resp_;
+};
+
+} // experimental
+} // aedis
+
+#endif // AEDIS_EXPERIMENTAL_HUB_HPP
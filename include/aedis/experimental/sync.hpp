@@ -7,21 +7,19 @@
 #ifndef AEDIS_EXPERIMENTAL_SYNC_HPP
 #define AEDIS_EXPERIMENTAL_SYNC_HPP
 
+#include <system_error>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/bind_executor.hpp>
+
 #include <aedis/adapt.hpp>
 #include <aedis/connection.hpp>
 #include <aedis/resp3/request.hpp>
+#include <aedis/experimental/detail/submission.hpp>
 
 namespace aedis {
 namespace experimental {
-namespace detail {
-
-struct sync {
-   std::mutex mutex;
-   std::condition_variable cv;
-   bool ready = false;
-};
-
-} // detail
 
 /** @brief Executes a command.
  *  @ingroup any
@@ -42,24 +40,20 @@ exec(
    ResponseAdapter adapter,
    boost::system::error_code& ec)
 {
-   detail::sync sh;
+   detail::waiter done;
    std::size_t res = 0;
 
-   auto f = [&conn, &ec, &res, &sh, &req, adapter]()
+   auto f = [&conn, &ec, &res, &done, &req, adapter]()
    {
-      conn.async_exec(req, adapter, [&sh, &res, &ec](auto const& ecp, std::size_t n) {
-         std::unique_lock ul(sh.mutex);
+      conn.async_exec(req, adapter, [&done, &res, &ec](auto const& ecp, std::size_t n) {
          ec = ecp;
          res = n;
-         sh.ready = true;
-         ul.unlock();
-         sh.cv.notify_one();
+         done.notify();
       });
    };
 
    boost::asio::dispatch(boost::asio::bind_executor(conn.get_executor(), f));
-   std::unique_lock lk(sh.mutex);
-   sh.cv.wait(lk, [&sh]{return sh.ready;});
+   done.wait();
    return res;
 }
 
@@ -107,26 +101,20 @@ auto receive_event(
    boost::system::error_code& ec)
 {
    using event_type = typename Connection::event;
-   std::mutex mutex;
-   std::condition_variable cv;
-   bool ready = false;
+   detail::waiter done;
    event_type ev = event_type::invalid;
 
-   auto f = [&conn, &ec, &ev, &mutex, &cv, &ready, adapter]()
+   auto f = [&conn, &ec, &ev, &done, adapter]()
    {
-      conn.async_receive_event(adapter, [&cv, &mutex, &ready, &ev, &ec](auto const& ecp, event_type evp) {
-         std::unique_lock ul(mutex);
+      conn.async_receive_event(adapter, [&done, &ev, &ec](auto const& ecp, event_type evp) {
          ec = ecp;
          ev = evp;
-         ready = true;
-         ul.unlock();
-         cv.notify_one();
+         done.notify();
       });
    };
 
    boost::asio::dispatch(boost::asio::bind_executor(conn.get_executor(), f));
-   std::unique_lock lk(mutex);
-   cv.wait(lk, [&ready]{return ready;});
+   done.wait();
    return ev;
 }
 
@@ -145,6 +133,113 @@ auto receive_event(
    return res;
 }
 
+/** @brief Executes requests from many threads on one connection.
+ *  @ingroup any
+ *
+ *  Requests are pushed to a lock-free queue that is drained by the
+ *  executor of the connection, the first request pushed to an empty
+ *  queue posts the drain so that requests submitted concurrently are
+ *  started, and written, together. The calling threads block on a
+ *  futex where available, no allocation or mutex is needed per
+ *  request. For example
+ *
+ *  @code
+ *  aedis::experimental::submitter<connection> sub{conn};
+ *
+ *  // From any thread.
+ *  sub.exec(req, adapt(resp));
+ *  @endcode
+ *
+ *  The submitter must outlive all calls to \c exec.
+ */
+template <class Connection>
+class submitter {
+public:
+   /// Constructor.
+   explicit submitter(Connection& conn) : conn_{conn} {}
+
+   /** @brief Executes a request, blocking until it completes.
+    *
+    *  @param req The request.
+    *  @param adapter The response adapter.
+    *  @param ec Error code in case of error.
+    *  @returns The number of bytes of the response.
+    */
+   template <class ResponseAdapter>
+   std::size_t
+   exec(
+      resp3::request const& req,
+      ResponseAdapter adapter,
+      boost::system::error_code& ec)
+   {
+      op<ResponseAdapter> o{&req, adapter};
+      if (queue_.push(&o))
+         boost::asio::post(conn_.get_executor(), [this]() { drain(); });
+
+      o.done.wait();
+      ec = o.ec;
+      return o.size;
+   }
+
+   /** @brief Executes a request, blocking until it completes.
+    *
+    *  @param req The request.
+    *  @param adapter The response adapter.
+    *  @throws std::system_error in case of error.
+    *  @returns The number of bytes of the response.
+    */
+   template <class ResponseAdapter = aedis::detail::response_traits<void>::adapter_type>
+   std::size_t exec(resp3::request const& req, ResponseAdapter adapter = aedis::adapt())
+   {
+      boost::system::error_code ec;
+      auto const res = exec(req, adapter, ec);
+      if (ec)
+         throw std::system_error(ec);
+      return res;
+   }
+
+private:
+   struct op_base : detail::submission {
+      void (*start)(op_base*, Connection&) = nullptr;
+      detail::waiter done;
+      boost::system::error_code ec;
+      std::size_t size = 0;
+   };
+
+   template <class ResponseAdapter>
+   struct op : op_base {
+      op(resp3::request const* r, ResponseAdapter a)
+      : req{r}, adapter{a}
+      { this->start = &op::start_exec; }
+
+      static void start_exec(op_base* base, Connection& conn)
+      {
+         auto* self = static_cast<op*>(base);
+         conn.async_exec(*self->req, self->adapter, [self](auto const& ec, std::size_t n) {
+            self->ec = ec;
+            self->size = n;
+            self->done.notify();
+         });
+      }
+
+      resp3::request const* req;
+      ResponseAdapter adapter;
+   };
+
+   void drain()
+   {
+      auto* s = queue_.pop_all();
+      while (s != nullptr) {
+         auto* base = static_cast<op_base*>(s);
+         s = s->next;
+         base->start(base, conn_);
+      }
+   }
+
+   Connection& conn_;
+   detail::submission_queue queue_;
+};
+
 } // experimental
 } // aedis
 
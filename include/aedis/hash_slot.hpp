@@ -0,0 +1,35 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_HASH_SLOT_HPP
+#define AEDIS_HASH_SLOT_HPP
+
+#include <cstddef>
+#include <boost/utility/string_view.hpp>
+
+namespace aedis {
+
+/// The number of hash slots in a Redis cluster.
+constexpr std::size_t hash_slots = 16384;
+
+/** \brief Calculates the Redis cluster hash slot of a key.
+ *  \ingroup any
+ *
+ *  The slot is the CRC16 of the key modulo 16384. If the key contains
+ *  a non-empty hash tag e.g. \c {user1000}.following only the
+ *  substring between the braces is hashed, see
+ *  https://redis.io/docs/reference/cluster-spec/#hash-tags.
+ *
+ *  Sharded channels (see \c SSUBSCRIBE and \c SPUBLISH) are mapped to
+ *  slots in the same way.
+ *
+ *  \param key The key or sharded channel.
+ */
+std::size_t hash_slot(boost::string_view key) noexcept;
+
+} // aedis
+
+#endif // AEDIS_HASH_SLOT_HPP
@@ -0,0 +1,69 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <aedis/coalescing_policy.hpp>
+
+namespace aedis {
+namespace detail {
+
+// Exponentially weighted moving average with weight 1/8.
+inline
+std::chrono::nanoseconds
+ewma(std::chrono::nanoseconds avg, std::chrono::nanoseconds sample) noexcept
+{
+   if (avg.count() == 0)
+      return sample;
+
+   return avg + (sample - avg) / 8;
+}
+
+} // detail
+
+coalescing_policy::coalescing_policy(
+   std::chrono::microseconds max_delay,
+   std::size_t max_bytes,
+   std::size_t max_commands) noexcept
+: max_delay_{max_delay}
+, max_bytes_{max_bytes}
+, max_commands_{max_commands}
+{ }
+
+void coalescing_policy::on_arrival(time_point now) noexcept
+{
+   if (last_arrival_ != time_point{}) {
+      // Clamped so that the average recovers quickly after idle
+      // periods, anything longer than the window is equally slow.
+      auto const gap = (std::min)(duration{now - last_arrival_}, 2 * max_delay_);
+      gap_ = detail::ewma(gap_, (std::max)(gap, duration{1}));
+   }
+
+   last_arrival_ = now;
+}
+
+void coalescing_policy::on_round_trip(duration rtt) noexcept
+{
+   rtt_ = detail::ewma(rtt_, (std::max)(rtt, duration{1}));
+}
+
+auto
+coalescing_policy::window(
+   std::size_t bytes,
+   std::size_t commands) const noexcept -> duration
+{
+   if (!enabled() || full(bytes, commands) || gap_.count() == 0 || rtt_.count() == 0)
+      return duration{0};
+
+   auto const max = (std::min)(duration{max_delay_}, rtt_ / 4);
+   if (gap_ >= max)
+      return duration{0};
+
+   // No need to wait longer than the time expected to fill the batch.
+   auto const missing = static_cast<duration::rep>(max_commands_ - commands);
+   return (std::min)(max, gap_ * missing);
+}
+
+} // aedis
@@ -0,0 +1,265 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <aedis/diagnostics.hpp>
+#include <aedis/resp3/command.hpp>
+
+namespace aedis {
+namespace detail {
+
+/* The position of the first key of a command, one for unknown
+ * commands and zero for commands without key. Sharded channels are
+ * not keys here.
+ */
+std::size_t first_key_position(boost::string_view cmd)
+{
+   auto const* info = resp3::find_command(cmd);
+   if (info == nullptr)
+      return 1;
+
+   if (info->kind == resp3::command_kind::pubsub || info->kind == resp3::command_kind::subscribe)
+      return 0;
+
+   return static_cast<std::size_t>(info->first_key);
+}
+
+} // detail
+
+slow_log::slow_log(
+   std::chrono::microseconds threshold,
+   std::size_t capacity,
+   std::size_t max_args_size)
+: threshold_{threshold}
+, capacity_{capacity}
+, max_args_size_{max_args_size}
+{
+   BOOST_ASSERT(capacity_ != 0);
+}
+
+void slow_log::add(slow_request req)
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   if (ring_.size() < capacity_)
+      ring_.push_back(std::move(req));
+   else
+      ring_[total_ % capacity_] = std::move(req);
+
+   ++total_;
+}
+
+std::vector<slow_request> slow_log::entries() const
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   if (ring_.size() < capacity_)
+      return ring_;
+
+   // The oldest entry is the next to be overwritten.
+   auto const first = static_cast<std::ptrdiff_t>(total_ % capacity_);
+   std::vector<slow_request> ret;
+   ret.reserve(ring_.size());
+   ret.insert(std::end(ret), std::begin(ring_) + first, std::end(ring_));
+   ret.insert(std::end(ret), std::begin(ring_), std::begin(ring_) + first);
+   return ret;
+}
+
+std::uint64_t slow_log::total() const
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   return total_;
+}
+
+void slow_log::clear()
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   ring_.clear();
+   total_ = 0;
+}
+
+hot_keys::hot_keys(std::size_t capacity, std::size_t sample_rate)
+: capacity_{capacity}
+, sample_rate_{sample_rate == 0 ? 1 : sample_rate}
+{
+   BOOST_ASSERT(capacity_ != 0);
+   entries_.reserve(capacity_);
+}
+
+void hot_keys::sample(resp3::request_view const& req)
+{
+   if (calls_.fetch_add(1, std::memory_order_relaxed) % sample_rate_ != 0)
+      return;
+
+   std::lock_guard<std::mutex> lk{mutex_};
+   detail::for_each_command(req.payload(), req.externals(), [this](auto const& cmd) {
+      auto const key = detail::first_key_position(cmd.args[0]);
+      if (key != 0 && key < (std::min)(cmd.size, cmd.max_args))
+         add_locked(cmd.args[key], sample_rate_);
+   });
+}
+
+void hot_keys::add(boost::string_view key, std::uint64_t n)
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   add_locked(key, n);
+}
+
+void hot_keys::add_locked(boost::string_view key, std::uint64_t n)
+{
+   std::string k{key.data(), key.size()};
+   auto iter = index_.find(k);
+   if (iter != std::end(index_)) {
+      entries_[iter->second].count += n;
+      return;
+   }
+
+   if (entries_.size() < capacity_) {
+      index_.emplace(k, entries_.size());
+      entries_.push_back({std::move(k), n, 0});
+      return;
+   }
+
+   // Replaces the key with the smallest count.
+   auto min = std::min_element(std::begin(entries_), std::end(entries_),
+      [](auto const& a, auto const& b) { return a.count < b.count; });
+
+   auto const i = static_cast<std::size_t>(std::distance(std::begin(entries_), min));
+   index_.erase(min->key);
+   index_.emplace(k, i);
+   min->error = min->count;
+   min->count += n;
+   min->key = std::move(k);
+}
+
+std::vector<hot_keys::entry> hot_keys::top(std::size_t n) const
+{
+   std::vector<entry> ret;
+   {
+      std::lock_guard<std::mutex> lk{mutex_};
+      ret = entries_;
+   }
+
+   std::sort(std::begin(ret), std::end(ret),
+      [](auto const& a, auto const& b) { return a.count > b.count; });
+
+   if (ret.size() > n)
+      ret.resize(n);
+
+   return ret;
+}
+
+void hot_keys::clear()
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   entries_.clear();
+   index_.clear();
+   calls_.store(0, std::memory_order_relaxed);
+}
+
+void diagnostics_tracer::on_exec(resp3::request_view const& req) noexcept
+{
+   try {
+      if (keys_)
+         keys_->sample(req);
+
+      if (!log_)
+         return;
+
+      pending const p{clock_type::now(), {}};
+      if (spare_.empty()) {
+         pending_[req.id()] = p;
+         return;
+      }
+
+      auto node = std::move(spare_.back());
+      spare_.pop_back();
+      node.key() = req.id();
+      node.mapped() = p;
+      auto const ret = pending_.insert(std::move(node));
+      if (!ret.inserted)
+         ret.position->second = p;
+   } catch (...) {
+      // The request is not sampled or, if not pending, not logged.
+   }
+}
+
+void diagnostics_tracer::on_write_begin(resp3::request_view const& req, std::size_t) noexcept
+{
+   if (!log_)
+      return;
+
+   auto iter = pending_.find(req.id());
+   if (iter != std::end(pending_))
+      iter->second.write = clock_type::now();
+}
+
+void
+diagnostics_tracer::on_response_end(
+   resp3::request_view const& req,
+   boost::system::error_code ec,
+   std::size_t size) noexcept
+{
+   if (!log_)
+      return;
+
+   auto iter = pending_.find(req.id());
+   if (iter == std::end(pending_))
+      return;
+
+   auto const p = iter->second;
+   auto node = pending_.extract(iter);
+   if (spare_.size() < max_spare_nodes) {
+      try {
+         spare_.push_back(std::move(node));
+      } catch (...) {
+         // The node is released.
+      }
+   }
+
+   auto const now = clock_type::now();
+   auto const total = std::chrono::duration_cast<std::chrono::microseconds>(now - p.exec);
+   if (total <= log_->threshold())
+      return;
+
+   try {
+      slow_request sr;
+      sr.commands = req.size();
+      sr.request_bytes = req.payload().size();
+      sr.response_bytes = size;
+      sr.total = total;
+      sr.queue = p.write == clock_type::time_point{}
+         ? total : std::chrono::duration_cast<std::chrono::microseconds>(p.write - p.exec);
+      sr.when = std::chrono::system_clock::now();
+      sr.error = ec;
+
+      auto const max = log_->max_args_size();
+      bool first = true;
+      detail::for_each_command(req.payload(), req.externals(), [&](auto const& cmd) {
+         if (!first || cmd.size == 0)
+            return;
+
+         first = false;
+         sr.command.assign(cmd.args[0].data(), cmd.args[0].size());
+         auto const n = std::min(cmd.size, detail::command_view::max_args);
+         for (std::size_t i = 1; i < n && sr.args.size() < max; ++i) {
+            if (i != 1)
+               sr.args += ' ';
+            sr.args.append(cmd.args[i].data(), cmd.args[i].size());
+         }
+
+         if (sr.args.size() > max || cmd.size > n) {
+            sr.args.resize(std::min(sr.args.size(), max));
+            sr.args += "...";
+         }
+      });
+
+      log_->add(std::move(sr));
+   } catch (...) {
+      // The request is not logged.
+   }
+}
+
+} // aedis
@@ -38,6 +38,7 @@ struct error_category_impl : boost::system::error_category {
 	 case error::incompatible_size: return "Aggregate container has incompatible size.";
 	 case error::not_a_double: return "Not a double.";
 	 case error::null: return "Got RESP3 null.";
+	 case error::handshake_timeout: return "TLS handshake timeout.";
 	 default:
             BOOST_ASSERT(false);
             return "Aedis error.";
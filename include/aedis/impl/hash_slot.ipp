@@ -0,0 +1,44 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <cstdint>
+#include <aedis/hash_slot.hpp>
+
+namespace aedis {
+namespace detail {
+
+// CRC16 XMODEM as specified in the Redis cluster specification.
+std::uint16_t crc16(char const* data, std::size_t size) noexcept
+{
+   std::uint16_t crc = 0;
+   for (std::size_t i = 0; i < size; ++i) {
+      crc ^= static_cast<std::uint16_t>(static_cast<unsigned char>(data[i]) << 8);
+      for (int j = 0; j < 8; ++j) {
+         if (crc & 0x8000)
+            crc = static_cast<std::uint16_t>((crc << 1) ^ 0x1021);
+         else
+            crc = static_cast<std::uint16_t>(crc << 1);
+      }
+   }
+
+   return crc;
+}
+
+} // detail
+
+std::size_t hash_slot(boost::string_view key) noexcept
+{
+   auto const open = key.find('{');
+   if (open != boost::string_view::npos) {
+      auto const close = key.find('}', open + 1);
+      if (close != boost::string_view::npos && close != open + 1)
+         key = key.substr(open + 1, close - open - 1);
+   }
+
+   return detail::crc16(key.data(), key.size()) & (hash_slots - 1);
+}
+
+} // aedis
@@ -0,0 +1,106 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <cmath>
+#include <boost/assert.hpp>
+#include <aedis/latency_histogram.hpp>
+
+namespace aedis {
+
+namespace {
+
+// Values below 2 * sub_buckets are recorded exactly, each power of two
+// above that is split into sub_buckets buckets.
+constexpr std::uint64_t sub_buckets = 16;
+constexpr std::uint64_t sub_bucket_bits = 4;
+constexpr std::uint64_t linear_buckets = 2 * sub_buckets;
+
+} // anonymous
+
+std::size_t latency_histogram::index(std::uint64_t v) noexcept
+{
+   if (v < linear_buckets)
+      return static_cast<std::size_t>(v);
+
+#if defined(__GNUC__)
+   std::uint64_t const msb = 63 - static_cast<std::uint64_t>(__builtin_clzll(v));
+#else
+   std::uint64_t msb = 0;
+   for (auto x = v; x >>= 1;)
+      ++msb;
+#endif
+
+   auto const shift = msb - sub_bucket_bits;
+   auto const i = linear_buckets + (shift - 1) * sub_buckets + ((v >> shift) - sub_buckets);
+   return i < buckets ? static_cast<std::size_t>(i) : buckets - 1;
+}
+
+std::uint64_t latency_histogram::highest_value(std::size_t i) noexcept
+{
+   if (i < linear_buckets)
+      return i;
+
+   auto const k = i - linear_buckets;
+   auto const shift = k / sub_buckets + 1;
+   auto const top = k % sub_buckets + sub_buckets;
+   return ((top + 1) << shift) - 1;
+}
+
+latency_histogram::duration latency_histogram::percentile(double p) const noexcept
+{
+   if (count_ == 0)
+      return duration{0};
+
+   p = p < 0 ? 0 : (p > 100 ? 100 : p);
+   auto target = static_cast<std::uint64_t>(std::ceil(p / 100 * static_cast<double>(count_)));
+   if (target == 0)
+      target = 1;
+
+   std::uint64_t acc = 0;
+   for (std::size_t i = 0; i < buckets; ++i) {
+      acc += counts_[i];
+      if (acc >= target) {
+         auto const v = highest_value(i);
+         return duration{static_cast<duration::rep>(v < max_ ? v : max_)};
+      }
+   }
+
+   BOOST_ASSERT(false);
+   return max();
+}
+
+void latency_histogram::merge(latency_histogram const& other) noexcept
+{
+   for (std::size_t i = 0; i < buckets; ++i)
+      counts_[i] += other.counts_[i];
+
+   count_ += other.count_;
+   sum_ += other.sum_;
+   if (other.max_ > max_)
+      max_ = other.max_;
+}
+
+void latency_histogram::reset() noexcept
+{
+   counts_.fill(0);
+   count_ = 0;
+   sum_ = 0;
+   max_ = 0;
+}
+
+char const* to_string(latency_phase p) noexcept
+{
+   switch (p) {
+      case latency_phase::queue: return "queue";
+      case latency_phase::write: return "write";
+      case latency_phase::server: return "server";
+      case latency_phase::parse: return "parse";
+      case latency_phase::total: return "total";
+      default: BOOST_ASSERT(false); return "unknown";
+   }
+}
+
+} // aedis
@@ -0,0 +1,46 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <aedis/reconnect_policy.hpp>
+
+namespace aedis {
+
+reconnect_policy::reconnect_policy(
+   duration base,
+   duration cap,
+   bool fast_first_retry)
+: base_{base}
+, cap_{(std::max)(base, cap)}
+, last_{base}
+, fast_first_retry_{fast_first_retry}
+, gen_{std::random_device{}()}
+{ }
+
+auto reconnect_policy::next() -> duration
+{
+   if (attempts_ == 0 && fast_first_retry_)
+      last_ = uniform(duration::zero(), base_);
+   else
+      last_ = uniform(base_, (std::min)(cap_, 3 * (std::max)(last_, base_)));
+
+   ++attempts_;
+   return last_;
+}
+
+void reconnect_policy::reset() noexcept
+{
+   attempts_ = 0;
+   last_ = base_;
+}
+
+auto reconnect_policy::uniform(duration lo, duration hi) -> duration
+{
+   std::uniform_int_distribution<duration::rep> dist{lo.count(), hi.count()};
+   return duration{dist(gen_)};
+}
+
+} // aedis
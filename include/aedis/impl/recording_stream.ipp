@@ -0,0 +1,99 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <stdexcept>
+#include <aedis/recording_stream.hpp>
+
+namespace aedis {
+namespace {
+
+char const magic[] = {'A', 'E', 'D', 'I', 'S', 'R', 'E', 'C', 1};
+
+} // anonymous
+
+traffic_recorder::traffic_recorder(std::string const& path)
+: file_{path, std::ios::binary | std::ios::trunc}
+, last_{std::chrono::steady_clock::now()}
+{
+   if (!file_)
+      throw std::runtime_error{"traffic_recorder: Unable to open " + path};
+
+   file_.write(magic, sizeof magic);
+}
+
+void traffic_recorder::write_varint(std::uint64_t v)
+{
+   char buf[10];
+   std::size_t n = 0;
+   do {
+      auto byte = static_cast<unsigned char>(v & 0x7f);
+      v >>= 7;
+      if (v != 0)
+         byte |= 0x80;
+      buf[n++] = static_cast<char>(byte);
+   } while (v != 0);
+
+   file_.write(buf, static_cast<std::streamsize>(n));
+}
+
+void traffic_recorder::write_header(traffic_direction d, std::size_t n)
+{
+   auto const now = std::chrono::steady_clock::now();
+   auto const delay = std::chrono::duration_cast<std::chrono::microseconds>(now - last_);
+   last_ = now;
+
+   file_.put(static_cast<char>(d));
+   write_varint(static_cast<std::uint64_t>(delay.count()));
+   write_varint(n);
+}
+
+traffic_reader::traffic_reader(std::string const& path)
+: file_{path, std::ios::binary}
+{
+   if (!file_)
+      throw std::runtime_error{"traffic_reader: Unable to open " + path};
+
+   char buf[sizeof magic] = {};
+   file_.read(buf, sizeof buf);
+   if (!file_ || !std::equal(std::begin(buf), std::end(buf), std::begin(magic)))
+      throw std::runtime_error{"traffic_reader: Not a recording " + path};
+}
+
+bool traffic_reader::read_varint(std::uint64_t& v)
+{
+   v = 0;
+   for (unsigned shift = 0; shift < 64; shift += 7) {
+      auto const c = file_.get();
+      if (c == std::char_traits<char>::eof())
+         return false;
+
+      v |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+      if ((c & 0x80) == 0)
+         return true;
+   }
+
+   return false;
+}
+
+bool traffic_reader::next(traffic_record& rec)
+{
+   auto const d = file_.get();
+   if (d == std::char_traits<char>::eof() || d > static_cast<int>(traffic_direction::connection))
+      return false;
+
+   std::uint64_t delay = 0;
+   std::uint64_t size = 0;
+   if (!read_varint(delay) || !read_varint(size))
+      return false;
+
+   rec.direction = static_cast<traffic_direction>(d);
+   rec.delay = std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(delay)};
+   rec.data.resize(static_cast<std::size_t>(size));
+   file_.read(&rec.data[0], static_cast<std::streamsize>(size));
+   return static_cast<std::uint64_t>(file_.gcount()) == size;
+}
+
+} // aedis
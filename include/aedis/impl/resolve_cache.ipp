@@ -0,0 +1,65 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <aedis/resolve_cache.hpp>
+
+namespace aedis {
+
+resolve_cache::resolve_cache(std::chrono::milliseconds ttl)
+: ttl_{ttl}
+{ }
+
+bool
+resolve_cache::find(
+   std::string const& host,
+   std::string const& port,
+   endpoints_type& endpoints,
+   bool stale) const
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   auto iter = entries_.find(key_type{host, port});
+   if (iter == std::end(entries_))
+      return false;
+
+   if (!stale && iter->second.expires <= clock_type::now())
+      return false;
+
+   endpoints = iter->second.endpoints;
+   return true;
+}
+
+void
+resolve_cache::insert(
+   std::string const& host,
+   std::string const& port,
+   endpoints_type endpoints)
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   entries_[key_type{host, port}] = entry{std::move(endpoints), clock_type::now() + ttl_};
+}
+
+void resolve_cache::mark_stale(std::string const& host, std::string const& port)
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   auto iter = entries_.find(key_type{host, port});
+   if (iter != std::end(entries_))
+      iter->second.expires = (std::min)(iter->second.expires, clock_type::now());
+}
+
+void resolve_cache::erase(std::string const& host, std::string const& port)
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   entries_.erase(key_type{host, port});
+}
+
+std::size_t resolve_cache::size() const
+{
+   std::lock_guard<std::mutex> lk{mutex_};
+   return entries_.size();
+}
+
+} // aedis
@@ -0,0 +1,71 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <aedis/stats.hpp>
+
+namespace aedis {
+namespace {
+
+struct metric {
+   char const* name;
+   char const* type;
+   char const* help;
+   std::uint64_t connection_stats::* value;
+};
+
+metric const metrics[] =
+{ {"requests_queued_total", "counter", "Requests passed to async_exec.", &connection_stats::requests_queued}
+, {"requests_in_flight", "gauge", "Requests that have not completed yet.", &connection_stats::requests_in_flight}
+, {"requests_completed_total", "counter", "Requests completed successfully.", &connection_stats::requests_completed}
+, {"requests_failed_total", "counter", "Requests completed with an error.", &connection_stats::requests_failed}
+, {"read_bytes_total", "counter", "Bytes of responses and pushes read.", &connection_stats::bytes_read}
+, {"written_bytes_total", "counter", "Bytes written.", &connection_stats::bytes_written}
+, {"pushes_received_total", "counter", "Server pushes received.", &connection_stats::pushes_received}
+, {"reconnects_total", "counter", "Reconnections.", &connection_stats::reconnects}
+, {"batches_written_total", "counter", "Writes of coalesced requests.", &connection_stats::batches_written}
+, {"batched_requests_total", "counter", "Requests written in batches.", &connection_stats::batched_requests}
+, {"max_batch_size", "gauge", "Size of the largest batch.", &connection_stats::max_batch_size}
+, {"read_buffer_high_water_bytes", "gauge", "Largest capacity of the read buffer.", &connection_stats::read_buffer_high_water}
+};
+
+// Label values escape backslash, double-quote and line feed.
+void append_label_value(std::string& out, std::string const& value)
+{
+   for (auto c: value) {
+      switch (c) {
+         case '\\': out += "\\\\"; break;
+         case '"': out += "\\\""; break;
+         case '\n': out += "\\n"; break;
+         default: out += c;
+      }
+   }
+}
+
+} // anonymous
+
+std::string
+to_prometheus(
+   std::vector<std::pair<std::string, connection_stats>> const& stats,
+   std::string const& prefix)
+{
+   std::string out;
+   for (auto const& m: metrics) {
+      auto const name = prefix.empty() ? std::string{m.name} : prefix + "_" + m.name;
+
+      out += "# HELP " + name + " " + m.help + "\n";
+      out += "# TYPE " + name + " " + m.type + "\n";
+
+      for (auto const& e: stats) {
+         out += name + "{connection=\"";
+         append_label_value(out, e.first);
+         out += "\"} " + std::to_string(e.second.*m.value) + "\n";
+      }
+   }
+
+   return out;
+}
+
+} // aedis
@@ -0,0 +1,127 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <thread>
+#include <boost/asio/connect.hpp>
+#include <aedis/sync_connection.hpp>
+
+namespace aedis {
+
+sync_connection::sync_connection()
+: sync_connection(config{})
+{ }
+
+sync_connection::sync_connection(config cfg)
+: cfg_{std::move(cfg)}
+, socket_{ioc_}
+{ }
+
+void sync_connection::connect(boost::system::error_code& ec)
+{
+   reconnect_policy policy{cfg_.reconnect_interval, cfg_.max_reconnect_interval, false};
+
+   for (std::size_t attempt = 1;; ++attempt) {
+      close();
+
+      using boost::asio::ip::tcp;
+      tcp::resolver resv{ioc_};
+      auto const res = resv.resolve(cfg_.host, cfg_.port, ec);
+      if (!ec)
+         boost::asio::connect(socket_, res, ec);
+
+      if (!ec) {
+         resp3::request req;
+         if (!std::empty(cfg_.username) && !std::empty(cfg_.password))
+            req.push("AUTH", cfg_.username, cfg_.password);
+         req.push("HELLO", "3");
+         req.append(cfg_.init);
+
+         resp3::write(socket_, req, ec);
+         if (!ec) {
+            detail::error_adapter adapter;
+            read_responses(req.size(), adapter, ec);
+         }
+      }
+
+      if (!ec) {
+         connected_once_ = true;
+         return;
+      }
+
+      close();
+
+      // Errors of the server e.g. a wrong password are not retried.
+      if (ec == error::simple_error || ec == error::blob_error)
+         return;
+
+      if (attempt >= cfg_.connect_attempts)
+         return;
+
+      std::this_thread::sleep_for(policy.next());
+   }
+}
+
+bool sync_connection::is_alive()
+{
+   // Responses are read before exec returns, so the socket can only
+   // be readable because of pushes or because the server closed it.
+   boost::system::error_code ec;
+   socket_.non_blocking(true, ec);
+   if (ec)
+      return false;
+
+   char c;
+   socket_.receive(boost::asio::buffer(&c, 1), boost::asio::socket_base::message_peek, ec);
+
+   boost::system::error_code ignored;
+   socket_.non_blocking(false, ignored);
+   return !ec || ec == boost::asio::error::would_block;
+}
+
+void sync_connection::write_buffers(boost::system::error_code& ec)
+{
+   ec = {};
+
+   bool reused = false;
+   if (is_open()) {
+      reused = is_alive();
+      if (!reused)
+         close();
+   }
+
+   if (!is_open()) {
+      if (!cfg_.enable_reconnect && connected_once_) {
+         ec = boost::asio::error::not_connected;
+         return;
+      }
+
+      connect(ec);
+      if (ec)
+         return;
+   }
+
+   boost::asio::write(socket_, buffers_, ec);
+   if (ec && reused && cfg_.enable_reconnect) {
+      // Closed by the server in the meantime, the request was not
+      // executed.
+      close();
+      connect(ec);
+      if (!ec)
+         boost::asio::write(socket_, buffers_, ec);
+   }
+
+   if (ec)
+      close();
+}
+
+void sync_connection::close()
+{
+   boost::system::error_code ignored;
+   socket_.close(ignored);
+   buffer_.clear();
+}
+
+} // aedis
@@ -0,0 +1,157 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <algorithm>
+#include <boost/assert.hpp>
+#include <aedis/timer_wheel.hpp>
+
+namespace aedis {
+
+void timer_wheel::entry::cancel() noexcept
+{
+   if (wheel_ != nullptr)
+      wheel_->unlink(*this);
+}
+
+timer_wheel::timer_wheel(
+   boost::asio::any_io_executor ex,
+   duration granularity)
+: granularity_{granularity}
+, start_{clock_type::now()}
+, timer_{ex}
+{
+   BOOST_ASSERT(granularity_.count() > 0);
+}
+
+timer_wheel::~timer_wheel()
+{
+   for (auto& slot: level0_)
+      while (slot != nullptr)
+         unlink(*slot);
+
+   for (auto& slot: level1_)
+      while (slot != nullptr)
+         unlink(*slot);
+}
+
+std::uint64_t timer_wheel::current_tick() const
+{
+   return static_cast<std::uint64_t>((clock_type::now() - start_) / granularity_);
+}
+
+void timer_wheel::arm(entry& e, duration after)
+{
+   e.cancel();
+
+   // The wheel is idle, no need to catch up.
+   if (size_ == 0)
+      now_ = current_tick();
+
+   // Rounds up so that the entry never expires too early.
+   auto const expiry = static_cast<std::uint64_t>((clock_type::now() + after - start_) / granularity_) + 1;
+
+   e.expiry_ = (std::max)(expiry, now_ + 1);
+   e.wheel_ = this;
+   link(e);
+   ++size_;
+   start();
+}
+
+void timer_wheel::link(entry& e)
+{
+   entry** slot = nullptr;
+   if (e.expiry_ - now_ < level0_slots) {
+      slot = &level0_[e.expiry_ % level0_slots];
+   } else {
+      // Entries beyond the second level are placed in its last slot
+      // and placed again when cascaded.
+      auto const last = now_ / level0_slots + level1_slots - 1;
+      slot = &level1_[(std::min)(e.expiry_ / level0_slots, last) % level1_slots];
+   }
+
+   e.slot_ = slot;
+   e.prev_ = nullptr;
+   e.next_ = *slot;
+   if (*slot != nullptr)
+      (*slot)->prev_ = &e;
+   *slot = &e;
+}
+
+void timer_wheel::unlink(entry& e) noexcept
+{
+   BOOST_ASSERT(e.wheel_ == this);
+   if (e.prev_ != nullptr)
+      e.prev_->next_ = e.next_;
+   else
+      *e.slot_ = e.next_;
+
+   if (e.next_ != nullptr)
+      e.next_->prev_ = e.prev_;
+
+   e.slot_ = nullptr;
+   e.prev_ = nullptr;
+   e.next_ = nullptr;
+   e.wheel_ = nullptr;
+   --size_;
+}
+
+void timer_wheel::process(std::uint64_t tick)
+{
+   now_ = tick;
+
+   // Cascades the second level slot of this round into the first.
+   if (tick % level0_slots == 0) {
+      auto& slot = level1_[(tick / level0_slots) % level1_slots];
+      auto* head = slot;
+      slot = nullptr;
+      while (head != nullptr) {
+         auto* e = head;
+         head = e->next_;
+         link(*e);
+      }
+   }
+
+   // The callbacks may arm and cancel other entries, including the
+   // ones in this slot.
+   auto& slot = level0_[tick % level0_slots];
+   while (slot != nullptr) {
+      auto* e = slot;
+      BOOST_ASSERT(e->expiry_ <= tick);
+      unlink(*e);
+      e->cb_(e->data_);
+   }
+}
+
+void timer_wheel::start()
+{
+   if (running_ || size_ == 0)
+      return;
+
+   BOOST_ASSERT_MSG(!weak_from_this().expired(), "timer_wheel must be created with std::make_shared.");
+
+   running_ = true;
+   timer_.expires_at(start_ + (now_ + 1) * granularity_);
+   timer_.async_wait([w = weak_from_this()](boost::system::error_code ec) {
+      auto self = w.lock();
+      if (self == nullptr || ec)
+         return;
+
+      self->on_timer();
+   });
+}
+
+void timer_wheel::on_timer()
+{
+   running_ = false;
+
+   auto const target = current_tick();
+   while (now_ < target && size_ != 0)
+      process(now_ + 1);
+
+   start();
+}
+
+} // aedis
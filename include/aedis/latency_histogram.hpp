@@ -0,0 +1,236 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_LATENCY_HISTOGRAM_HPP
+#define AEDIS_LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace aedis {
+
+/** \brief A histogram of latencies with bounded relative error.
+ *  \ingroup any
+ *
+ *  Buckets are laid out as in HDR histograms: every power of two is
+ *  split into 16 linear sub-buckets, so that values are recorded in
+ *  constant time with a relative error below 1/16. Values from 0ns to
+ *  2^37ns, about 137s, are tracked, larger values are counted in the
+ *  last bucket. The histogram takes about 4.3kB.
+ *
+ *  This class is not thread safe.
+ */
+class latency_histogram {
+public:
+   using duration = std::chrono::nanoseconds;
+
+   /// The number of buckets.
+   static constexpr std::size_t buckets = 544;
+
+   /// Records a value.
+   void record(duration d) noexcept
+   {
+      auto const v = d.count() < 0 ? 0 : static_cast<std::uint64_t>(d.count());
+      ++counts_[index(v)];
+      ++count_;
+      sum_ += v;
+      if (v > max_)
+         max_ = v;
+   }
+
+   /// Returns the number of recorded values.
+   std::uint64_t count() const noexcept { return count_; }
+
+   /// Returns the sum of the recorded values.
+   duration sum() const noexcept { return duration{static_cast<duration::rep>(sum_)}; }
+
+   /// Returns the largest recorded value.
+   duration max() const noexcept { return duration{static_cast<duration::rep>(max_)}; }
+
+   /** \brief Returns the value at a percentile.
+    *
+    *  \param p The percentile in the range [0, 100].
+    *  \returns The largest value equivalent to the value at the
+    *  percentile, or zero if the histogram is empty.
+    */
+   duration percentile(double p) const noexcept;
+
+   /** \brief Calls a function on every non-empty bucket.
+    *
+    *  The function is called in increasing order of values with the
+    *  largest value of the bucket and its count
+    *
+    *  @code
+    *  void f(latency_histogram::duration, std::uint64_t);
+    *  @endcode
+    */
+   template <class Function>
+   void for_each_bucket(Function f) const
+   {
+      for (std::size_t i = 0; i < buckets; ++i) {
+         if (counts_[i] != 0)
+            f(duration{static_cast<duration::rep>(highest_value(i))}, counts_[i]);
+      }
+   }
+
+   /// Adds the values of another histogram to this one.
+   void merge(latency_histogram const& other) noexcept;
+
+   /// Removes all values.
+   void reset() noexcept;
+
+private:
+   static std::size_t index(std::uint64_t v) noexcept;
+   static std::uint64_t highest_value(std::size_t i) noexcept;
+
+   std::array<std::uint64_t, buckets> counts_{};
+   std::uint64_t count_ = 0;
+   std::uint64_t sum_ = 0;
+   std::uint64_t max_ = 0;
+};
+
+/** \brief The phases of a request.
+ *  \ingroup any
+ */
+enum class latency_phase
+{
+   /// From async_exec to the start of the write of the request.
+   queue,
+   /// From the start to the completion of the write.
+   write,
+   /// From the completion of the write to the first byte of the response.
+   server,
+   /// From the first byte of the response to its parse completion.
+   parse,
+   /// From async_exec to the parse completion.
+   total,
+};
+
+/** \brief Converts a latency phase to a string.
+ *  \ingroup any
+ */
+char const* to_string(latency_phase p) noexcept;
+
+/** \brief The latency histograms of a connection, one per phase.
+ *  \ingroup any
+ *
+ *  Only available when \c AEDIS_ENABLE_LATENCY_HISTOGRAMS is defined,
+ *  see connection::get_latency_histograms. The macro changes the
+ *  layout of connection, so it must be defined in all translation
+ *  units of a program or in none, e.g. on the compiler command line.
+ *  Otherwise the program violates the one definition rule.
+ */
+class latency_histograms {
+public:
+   /// The number of phases.
+   static constexpr std::size_t phases = 5;
+
+   /// Returns the histogram of a phase.
+   latency_histogram const& operator[](latency_phase p) const noexcept
+      { return hists_[static_cast<std::size_t>(p)]; }
+
+   /// Returns the histogram of a phase.
+   latency_histogram& operator[](latency_phase p) noexcept
+      { return hists_[static_cast<std::size_t>(p)]; }
+
+   /// Removes all values.
+   void reset() noexcept
+   {
+      for (auto& h: hists_)
+         h.reset();
+   }
+
+private:
+   std::array<latency_histogram, phases> hists_;
+};
+
+namespace detail {
+
+#if defined(AEDIS_ENABLE_LATENCY_HISTOGRAMS)
+
+// Timestamps of a request, the hooks below are called by the
+// connection as the request progresses.
+struct latency_marks {
+   using time_point = std::chrono::steady_clock::time_point;
+
+   time_point enqueued;
+   time_point write_started;
+   time_point written;
+   time_point first_byte;
+};
+
+class latency_recorder {
+public:
+   using clock_type = std::chrono::steady_clock;
+
+   void on_enqueue(latency_marks& m) const noexcept
+      { m.enqueued = clock_type::now(); }
+
+   // Requests are written again after a reconnection.
+   void on_write_start(latency_marks& m) const noexcept
+   {
+      m.write_started = clock_type::now();
+      m.written = {};
+      m.first_byte = {};
+   }
+
+   // Marks all requests whose write is pending.
+   template <class Requests>
+   void on_write_complete(Requests const& reqs) const noexcept
+   {
+      auto const now = clock_type::now();
+      for (auto const& r: reqs) {
+         if (r->written && r->marks.written == latency_marks::time_point{})
+            r->marks.written = now;
+      }
+   }
+
+   void on_first_byte(latency_marks& m) const noexcept
+   {
+      if (m.first_byte == latency_marks::time_point{})
+         m.first_byte = clock_type::now();
+   }
+
+   void on_parsed(latency_marks const& m) noexcept
+   {
+      auto const now = clock_type::now();
+      hists_[latency_phase::queue].record(m.write_started - m.enqueued);
+      hists_[latency_phase::write].record(m.written - m.write_started);
+      hists_[latency_phase::server].record(m.first_byte - m.written);
+      hists_[latency_phase::parse].record(now - m.first_byte);
+      hists_[latency_phase::total].record(now - m.enqueued);
+   }
+
+   latency_histograms const& histograms() const noexcept { return hists_; }
+   latency_histograms& histograms() noexcept { return hists_; }
+
+private:
+   latency_histograms hists_;
+};
+
+#else
+
+// Compiles out when AEDIS_ENABLE_LATENCY_HISTOGRAMS is not defined.
+struct latency_marks {};
+
+class latency_recorder {
+public:
+   void on_enqueue(latency_marks&) const noexcept {}
+   void on_write_start(latency_marks&) const noexcept {}
+   template <class Requests>
+   void on_write_complete(Requests const&) const noexcept {}
+   void on_first_byte(latency_marks&) const noexcept {}
+   void on_parsed(latency_marks const&) const noexcept {}
+};
+
+#endif // AEDIS_ENABLE_LATENCY_HISTOGRAMS
+
+} // detail
+} // aedis
+
+#endif // AEDIS_LATENCY_HISTOGRAM_HPP
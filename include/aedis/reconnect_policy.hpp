@@ -0,0 +1,65 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RECONNECT_POLICY_HPP
+#define AEDIS_RECONNECT_POLICY_HPP
+
+#include <chrono>
+#include <random>
+#include <cstddef>
+
+namespace aedis {
+
+/** \brief Exponential backoff with decorrelated jitter.
+ *  \ingroup any
+ *
+ *  Calculates the time to wait before each reconnection attempt. The
+ *  first attempt waits a random time in <tt>[0, base]</tt> if fast
+ *  retry is enabled, each subsequent attempt waits a random time in
+ *  <tt>[base, 3 * previous]</tt>, capped at \c cap, see
+ *  https://aws.amazon.com/blogs/architecture/exponential-backoff-and-jitter/.
+ *  The randomness spreads the reconnections of many clients over time
+ *  when a server restarts.
+ */
+class reconnect_policy {
+public:
+   using duration = std::chrono::milliseconds;
+
+   /** \brief Constructor.
+    *
+    *  \param base The minimum wait time.
+    *  \param cap The maximum wait time.
+    *  \param fast_first_retry Whether the first attempt waits less than \c base.
+    */
+   explicit
+   reconnect_policy(
+      duration base = std::chrono::seconds{1},
+      duration cap = std::chrono::seconds{30},
+      bool fast_first_retry = true);
+
+   /// Returns the time to wait before the next attempt.
+   duration next();
+
+   /// Resets the backoff, to be called after a successful connection.
+   void reset() noexcept;
+
+   /// Returns the number of attempts since the last reset.
+   std::size_t attempts() const noexcept { return attempts_; }
+
+private:
+   duration uniform(duration lo, duration hi);
+
+   duration base_;
+   duration cap_;
+   duration last_;
+   std::size_t attempts_ = 0;
+   bool fast_first_retry_;
+   std::minstd_rand gen_;
+};
+
+} // aedis
+
+#endif // AEDIS_RECONNECT_POLICY_HPP
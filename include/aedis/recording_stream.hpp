@@ -0,0 +1,310 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RECORDING_STREAM_HPP
+#define AEDIS_RECORDING_STREAM_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/compose.hpp>
+#include <boost/asio/coroutine.hpp>
+#include <boost/asio/async_result.hpp>
+
+#include <aedis/detail/net.hpp>
+
+namespace aedis {
+
+/** \brief The direction of recorded traffic.
+ *  \ingroup any
+ */
+enum class traffic_direction : std::uint8_t
+{
+   /// Bytes written by the client.
+   sent = 0,
+   /// Bytes read by the client.
+   received = 1,
+   /// A new connection starts, carries no bytes.
+   connection = 2,
+};
+
+/** \brief Records raw traffic to a file.
+ *  \ingroup any
+ *
+ *  The file starts with the magic string \c AEDISREC and a version
+ *  byte, followed by records of the form
+ *
+ *  @code
+ *  direction (1 byte) | microseconds since the previous record (varint) | size (varint) | bytes
+ *  @endcode
+ *
+ *  where varints are LEB128 encoded. See traffic_reader and
+ *  recording_stream. This class is not thread safe and should be
+ *  used by a single connection.
+ */
+class traffic_recorder {
+public:
+   /** \brief Constructor.
+    *
+    *  \param path The file, truncated if it exists.
+    *  \throws std::runtime_error if the file can't be opened.
+    */
+   explicit traffic_recorder(std::string const& path);
+
+   /// Records the first \c n bytes of a buffer sequence.
+   template <class ConstBufferSequence>
+   void record(traffic_direction d, ConstBufferSequence const& buffers, std::size_t n)
+   {
+      if (n == 0 && d != traffic_direction::connection)
+         return;
+
+      write_header(d, n);
+      auto const end = boost::asio::buffer_sequence_end(buffers);
+      for (auto iter = boost::asio::buffer_sequence_begin(buffers); iter != end && n != 0; ++iter) {
+         boost::asio::const_buffer const b{*iter};
+         auto const size = (std::min)(n, b.size());
+         file_.write(static_cast<char const*>(b.data()), static_cast<std::streamsize>(size));
+         n -= size;
+      }
+   }
+
+   /// Flushes the file.
+   void flush() { file_.flush(); }
+
+private:
+   void write_header(traffic_direction d, std::size_t n);
+   void write_varint(std::uint64_t v);
+
+   std::ofstream file_;
+   std::chrono::steady_clock::time_point last_;
+};
+
+/** \brief A record read by traffic_reader.
+ *  \ingroup any
+ */
+struct traffic_record {
+   /// The direction of the bytes.
+   traffic_direction direction = traffic_direction::received;
+
+   /// Time since the previous record.
+   std::chrono::microseconds delay{0};
+
+   /// The recorded bytes.
+   std::string data;
+};
+
+/** \brief Reads files written by traffic_recorder.
+ *  \ingroup any
+ */
+class traffic_reader {
+public:
+   /** \brief Constructor.
+    *
+    *  \param path The file.
+    *  \throws std::runtime_error if the file can't be opened or is not
+    *  a recording.
+    */
+   explicit traffic_reader(std::string const& path);
+
+   /** \brief Reads the next record.
+    *
+    *  \returns False at the end of the file or if the last record is
+    *  truncated.
+    */
+   bool next(traffic_record& rec);
+
+private:
+   bool read_varint(std::uint64_t& v);
+
+   std::ifstream file_;
+};
+
+namespace detail {
+
+// Streams without layers, e.g. test streams, are their own lowest layer.
+template <class Stream, class = void>
+struct lowest_layer_of {
+   using type = Stream;
+};
+
+template <class Stream>
+struct lowest_layer_of<Stream, std::void_t<typename Stream::lowest_layer_type>> {
+   using type = typename Stream::lowest_layer_type;
+};
+
+#include <boost/asio/yield.hpp>
+
+template <class Stream, class Buffers, bool IsRead>
+struct recording_op {
+   Stream* next;
+   traffic_recorder* rec;
+   Buffers buffers;
+   boost::asio::coroutine coro{};
+
+   template <class Self>
+   void start(Self& self, std::true_type)
+      { next->async_read_some(buffers, std::move(self)); }
+
+   template <class Self>
+   void start(Self& self, std::false_type)
+      { next->async_write_some(buffers, std::move(self)); }
+
+   template <class Self>
+   void operator()(Self& self, boost::system::error_code ec = {}, std::size_t n = 0)
+   {
+      reenter (coro)
+      {
+         yield start(self, std::integral_constant<bool, IsRead>{});
+
+         if (rec != nullptr)
+            rec->record(IsRead ? traffic_direction::received : traffic_direction::sent, buffers, n);
+
+         self.complete(ec, n);
+      }
+   }
+};
+
+#include <boost/asio/unyield.hpp>
+
+} // detail
+
+/** \brief A stream that records the traffic of the next layer.
+ *  \ingroup any
+ *
+ *  Can be used as the next layer of a connection, with the recorder
+ *  passed to its constructor, e.g.
+ *
+ *  @code
+ *  using connection = aedis::connection<aedis::recording_stream<tcp::socket>>;
+ *  auto rec = std::make_shared<aedis::traffic_recorder>("capture.bin");
+ *  connection db{ioc, rec};
+ *  @endcode
+ *
+ *  Each (re)connection is marked in the file with a record of type
+ *  traffic_direction::connection. The recordings can be replayed with
+ *  the replay tool in the benchmarks directory.
+ */
+template <class Stream>
+class recording_stream {
+public:
+   /// The type of the next layer.
+   using next_layer_type = Stream;
+
+   /// The type of the lowest layer.
+   using lowest_layer_type = typename detail::lowest_layer_of<Stream>::type;
+
+   /// The executor type.
+   using executor_type = typename Stream::executor_type;
+
+   /** \brief Constructor.
+    *
+    *  \param arg Argument of the constructor of the next layer.
+    *  \param rec The recorder, may be null.
+    */
+   template <class Arg>
+   recording_stream(Arg&& arg, std::shared_ptr<traffic_recorder> rec)
+   : next_{std::forward<Arg>(arg)}
+   , rec_{std::move(rec)}
+   {
+      if (rec_ != nullptr)
+         rec_->record(traffic_direction::connection, boost::asio::const_buffer{}, 0);
+   }
+
+   /// Returns the executor.
+   executor_type get_executor() noexcept { return next_.get_executor(); }
+
+   /// Returns the next layer.
+   next_layer_type& next_layer() noexcept { return next_; }
+
+   /// Returns the lowest layer.
+   lowest_layer_type& lowest_layer() noexcept { return next_.lowest_layer(); }
+
+   /// Reads from the next layer and records the bytes read.
+   template <
+      class MutableBufferSequence,
+      class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
+   auto
+   async_read_some(
+      MutableBufferSequence const& buffers,
+      CompletionToken&& token = CompletionToken{})
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::size_t)
+         >(detail::recording_op<Stream, MutableBufferSequence, true>
+               {&next_, rec_.get(), buffers}, token, next_);
+   }
+
+   /// Writes to the next layer and records the bytes written.
+   template <
+      class ConstBufferSequence,
+      class CompletionToken = boost::asio::default_completion_token_t<executor_type>>
+   auto
+   async_write_some(
+      ConstBufferSequence const& buffers,
+      CompletionToken&& token = CompletionToken{})
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code, std::size_t)
+         >(detail::recording_op<Stream, ConstBufferSequence, false>
+               {&next_, rec_.get(), buffers}, token, next_);
+   }
+
+private:
+   Stream next_;
+   std::shared_ptr<traffic_recorder> rec_;
+};
+
+namespace detail {
+
+// Next layer of connections that record their traffic.
+template <class Stream>
+struct layer<recording_stream<Stream>> {
+   using stream_type = recording_stream<Stream>;
+
+   static constexpr bool requires_handshake = false;
+
+   explicit layer(std::shared_ptr<traffic_recorder>& rec) noexcept
+   : rec_{rec}
+   { }
+
+   template <class Executor>
+   std::shared_ptr<stream_type> make_stream(Executor ex) const
+      { return std::make_shared<stream_type>(ex, rec_); }
+
+   // Never called since requires_handshake is false.
+   template <class CompletionToken>
+   auto async_handshake(stream_type& stream, std::string const&, CompletionToken&& token)
+   {
+      return boost::asio::async_compose
+         < CompletionToken
+         , void(boost::system::error_code)
+         >([](auto& self) { self.complete({}); }, token, stream);
+   }
+
+   void on_close(stream_type&) noexcept
+   {
+      if (rec_ != nullptr)
+         rec_->flush();
+   }
+
+private:
+   std::shared_ptr<traffic_recorder> rec_;
+};
+
+} // detail
+} // aedis
+
+#endif // AEDIS_RECORDING_STREAM_HPP
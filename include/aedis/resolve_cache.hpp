@@ -0,0 +1,94 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESOLVE_CACHE_HPP
+#define AEDIS_RESOLVE_CACHE_HPP
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/asio/ip/tcp.hpp>
+
+namespace aedis {
+
+/** \brief A cache of resolved addresses shared among connections.
+ *  \ingroup any
+ *
+ *  Connections that share a cache (see connection::config::resolve_cache)
+ *  only resolve the host when its entry is older than the
+ *  time-to-live. If the resolution fails the expired entry is used
+ *  instead, so that a temporary DNS failure does not prevent
+ *  reconnection. Entries are marked stale when none of their
+ *  endpoints accepts a connection, e.g. when the server restarts, so
+ *  that the next attempt resolves the host again but can still fall
+ *  back to them.
+ *
+ *  This class is thread safe.
+ */
+class resolve_cache {
+public:
+   using clock_type = std::chrono::steady_clock;
+
+   /// The type of the cached endpoints.
+   using endpoints_type = std::vector<boost::asio::ip::tcp::endpoint>;
+
+   /** \brief Constructor.
+    *
+    *  \param ttl The time-to-live of the entries.
+    */
+   explicit resolve_cache(std::chrono::milliseconds ttl = std::chrono::seconds{30});
+
+   /** \brief Finds the endpoints of a host.
+    *
+    *  \param host The host.
+    *  \param port The port.
+    *  \param endpoints Set to the cached endpoints when found.
+    *  \param stale Whether expired entries are also returned.
+    *  \returns True if found.
+    */
+   bool
+   find(
+      std::string const& host,
+      std::string const& port,
+      endpoints_type& endpoints,
+      bool stale = false) const;
+
+   /// Adds or replaces the endpoints of a host.
+   void insert(std::string const& host, std::string const& port, endpoints_type endpoints);
+
+   /** \brief Marks the endpoints of a host as expired.
+    *
+    *  They are then only returned by \c find when stale entries are
+    *  accepted.
+    */
+   void mark_stale(std::string const& host, std::string const& port);
+
+   /// Removes the endpoints of a host.
+   void erase(std::string const& host, std::string const& port);
+
+   /// Returns the number of entries, including expired ones.
+   std::size_t size() const;
+
+private:
+   struct entry {
+      endpoints_type endpoints;
+      clock_type::time_point expires;
+   };
+
+   using key_type = std::pair<std::string, std::string>;
+
+   mutable std::mutex mutex_;
+   std::chrono::milliseconds ttl_;
+   std::map<key_type, entry> entries_;
+};
+
+} // aedis
+
+#endif // AEDIS_RESOLVE_CACHE_HPP
@@ -0,0 +1,259 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_COMMAND_HPP
+#define AEDIS_RESP3_COMMAND_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/utility/string_view.hpp>
+#include <aedis/resp3/detail/command_table.hpp>
+
+namespace aedis {
+namespace resp3 {
+
+/** \brief The Redis commands known at compile time.
+ *  \ingroup any
+ *
+ *  The enumerators are the command names in lower case, READONLY is
+ *  \c command::readonly. See also command_info.
+ */
+enum class command : std::uint8_t
+{
+#define AEDIS_RESP3_COMMAND_ID(id, name, arity, first, last, step, kind) id,
+   AEDIS_RESP3_COMMAND_TABLE(AEDIS_RESP3_COMMAND_ID)
+#undef AEDIS_RESP3_COMMAND_ID
+};
+
+/** \brief How a command accesses the data.
+ *  \ingroup any
+ */
+enum class command_kind : std::uint8_t
+{
+   /// Neither reads nor writes keys e.g. PING.
+   other,
+   /// Only reads, can be sent to replicas.
+   readonly,
+   /// Modifies the data.
+   write,
+   /// Pub/Sub command with a regular response e.g. PUBLISH.
+   pubsub,
+   /// Pub/Sub command whose responses are pushes e.g. SUBSCRIBE.
+   subscribe,
+};
+
+/** \brief Command metadata, as in the output of \c COMMAND \c INFO.
+ *  \ingroup any
+ */
+struct command_info {
+   /// The command.
+   command id;
+
+   /// The command name in upper case.
+   boost::string_view name;
+
+   /// The number of arguments including the name, negative for a minimum.
+   std::int8_t arity;
+
+   /// The position of the first key, zero when there is none or it is movable.
+   std::int8_t first_key;
+
+   /// The position of the last key, negative counts from the end.
+   std::int8_t last_key;
+
+   /// The step between keys.
+   std::int8_t key_step;
+
+   /// The kind of command.
+   command_kind kind;
+
+   /// Whether \c n arguments, including the name, are valid.
+   constexpr bool accepts(std::size_t n) const noexcept
+   {
+      return arity >= 0 ? n == static_cast<std::size_t>(arity)
+                        : n >= static_cast<std::size_t>(-arity);
+   }
+
+   /// Whether the response is a push instead of a regular response.
+   constexpr bool has_push_response() const noexcept
+      { return kind == command_kind::subscribe; }
+
+   /// Whether the command has a key at a fixed position.
+   constexpr bool has_key() const noexcept
+      { return first_key > 0; }
+};
+
+namespace detail {
+
+inline constexpr command_info command_infos[] =
+{
+#define AEDIS_RESP3_COMMAND_INFO(id, name, arity, first, last, step, kind) \
+   {command::id, name, arity, first, last, step, command_kind::kind},
+   AEDIS_RESP3_COMMAND_TABLE(AEDIS_RESP3_COMMAND_INFO)
+#undef AEDIS_RESP3_COMMAND_INFO
+};
+
+constexpr std::size_t command_count = sizeof command_infos / sizeof command_infos[0];
+
+constexpr char to_upper(char c) noexcept
+   { return ('a' <= c && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c; }
+
+// FNV-1a of the name in upper case, the seed selects the function.
+constexpr std::uint32_t
+command_hash(boost::string_view name, std::uint32_t seed = 0) noexcept
+{
+   std::uint32_t h = 2166136261U ^ (seed * 16777619U);
+   for (std::size_t i = 0; i < name.size(); ++i) {
+      h ^= static_cast<unsigned char>(to_upper(name.data()[i]));
+      h *= 16777619U;
+   }
+
+   return h ^ (h >> 15);
+}
+
+// Compares with a name in the table, which is in upper case.
+constexpr bool command_name_equal(boost::string_view upper, boost::string_view name) noexcept
+{
+   if (upper.size() != name.size())
+      return false;
+
+   for (std::size_t i = 0; i < name.size(); ++i) {
+      if (upper.data()[i] != to_upper(name.data()[i]))
+         return false;
+   }
+
+   return true;
+}
+
+/* Perfect hash built at compile time by hash and displace. The names
+ * are split in buckets by command_hash with seed zero, each bucket has
+ * a seed that places all its names in free slots. A lookup hashes the
+ * name twice and compares it with at most one name in the table.
+ */
+struct command_index {
+   static constexpr std::size_t size = 256;
+   static constexpr std::size_t buckets = 64;
+   static constexpr std::uint32_t max_seed = 1U << 16;
+
+   // One plus the position in command_infos, zero if empty.
+   std::uint8_t slots[size] = {};
+   std::uint16_t seeds[buckets] = {};
+   bool complete = true;
+};
+
+constexpr command_index make_command_index() noexcept
+{
+   command_index ret;
+
+   std::size_t bucket_of[command_count] = {};
+   std::size_t bucket_size[command_index::buckets] = {};
+   for (std::size_t i = 0; i < command_count; ++i) {
+      bucket_of[i] = command_hash(command_infos[i].name) % command_index::buckets;
+      ++bucket_size[bucket_of[i]];
+   }
+
+   // The largest buckets are placed first, while most slots are free.
+   std::size_t order[command_index::buckets] = {};
+   for (std::size_t b = 0; b < command_index::buckets; ++b)
+      order[b] = b;
+
+   for (std::size_t i = 0; i < command_index::buckets; ++i) {
+      for (std::size_t j = i + 1; j < command_index::buckets; ++j) {
+         if (bucket_size[order[j]] > bucket_size[order[i]]) {
+            auto const tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+         }
+      }
+   }
+
+   for (std::size_t k = 0; k < command_index::buckets && bucket_size[order[k]] != 0; ++k) {
+      auto const b = order[k];
+      std::uint32_t seed = 1;
+      for (; seed < command_index::max_seed; ++seed) {
+         bool taken[command_index::size] = {};
+         bool fits = true;
+         for (std::size_t i = 0; i < command_count && fits; ++i) {
+            if (bucket_of[i] != b)
+               continue;
+
+            auto const j = command_hash(command_infos[i].name, seed) % command_index::size;
+            fits = ret.slots[j] == 0 && !taken[j];
+            taken[j] = true;
+         }
+
+         if (fits)
+            break;
+      }
+
+      if (seed == command_index::max_seed) {
+         ret.complete = false;
+         return ret;
+      }
+
+      ret.seeds[b] = static_cast<std::uint16_t>(seed);
+      for (std::size_t i = 0; i < command_count; ++i) {
+         if (bucket_of[i] == b) {
+            auto const j = command_hash(command_infos[i].name, seed) % command_index::size;
+            ret.slots[j] = static_cast<std::uint8_t>(i + 1);
+         }
+      }
+   }
+
+   return ret;
+}
+
+inline constexpr command_index command_lookup = make_command_index();
+
+static_assert(command_count < 256, "Command index slots are too small.");
+static_assert(command_count < command_index::size, "Command index is too small.");
+static_assert(command_lookup.complete, "No perfect hash for the command table.");
+
+} // detail
+
+/** \brief Returns the metadata of a command.
+ *  \ingroup any
+ *
+ *  Resolved at compile time in constant expressions, for example
+ *
+ *  @code
+ *  static_assert(info(command::hgetall).kind == command_kind::readonly);
+ *  @endcode
+ */
+constexpr command_info const& info(command cmd) noexcept
+   { return detail::command_infos[static_cast<std::size_t>(cmd)]; }
+
+/** \brief Looks up a command by name.
+ *  \ingroup any
+ *
+ *  The lookup uses a perfect hash and compares the name with at most
+ *  one command, independently of the number of commands. Names are
+ *  case insensitive.
+ *
+ *  \param name The command name e.g. "HGETALL".
+ *  \returns The metadata or \c nullptr if the command is not known.
+ */
+constexpr command_info const* find_command(boost::string_view name) noexcept
+{
+   auto const b = detail::command_hash(name) % detail::command_index::buckets;
+   auto const seed = detail::command_lookup.seeds[b];
+   if (seed == 0)
+      return nullptr;
+
+   auto const j = detail::command_hash(name, seed) % detail::command_index::size;
+   auto const slot = detail::command_lookup.slots[j];
+   if (slot == 0)
+      return nullptr;
+
+   auto const& cmd = detail::command_infos[slot - 1];
+   return detail::command_name_equal(cmd.name, name) ? &cmd : nullptr;
+}
+
+} // resp3
+} // aedis
+
+#endif // AEDIS_RESP3_COMMAND_HPP
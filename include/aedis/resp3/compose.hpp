@@ -7,8 +7,11 @@
 #ifndef AEDIS_RESP3_COMPOSE_HPP
 #define AEDIS_RESP3_COMPOSE_HPP
 
+#include <limits>
 #include <string>
 #include <tuple>
+#include <charconv>
+#include <type_traits>
 
 #include <boost/hana.hpp>
 #include <boost/utility/string_view.hpp>
@@ -20,6 +23,60 @@ namespace resp3 {
 
 constexpr char separator[] = "\r\n";
 
+namespace detail {
+
+// The decimal representation of an integer, without allocating.
+template <class T>
+struct integer_chars {
+   // The unary plus promotes bool and char as std::to_string does.
+   using value_type = decltype(+T{});
+
+   explicit integer_chars(T n) noexcept
+   : size{static_cast<std::size_t>(std::to_chars(buffer, buffer + sizeof buffer, value_type{+n}).ptr - buffer)}
+   { }
+
+   boost::string_view view() const noexcept
+      { return {buffer, size}; }
+
+   // The digits and a sign.
+   static constexpr std::size_t max_size = std::numeric_limits<value_type>::digits10 + 2;
+
+   char buffer[max_size];
+   std::size_t size;
+};
+
+// The maximum size of e.g. "$42\r\n".
+constexpr std::size_t max_prefix_size = 1 + integer_chars<std::size_t>::max_size + 2;
+
+// Writes e.g. "$42\r\n" to out and returns its size.
+inline std::size_t format_prefix(char* out, type t, std::size_t size) noexcept
+{
+   out[0] = to_code(t);
+   auto* end = std::to_chars(out + 1, out + max_prefix_size, size).ptr;
+   *end++ = '\r';
+   *end++ = '\n';
+   return static_cast<std::size_t>(end - out);
+}
+
+// Appends e.g. "$42\r\n" with a single append.
+template <class Request>
+void append_prefix(Request& to, type t, std::size_t size)
+{
+   char buffer[max_prefix_size];
+   to.append(buffer, format_prefix(buffer, t, size));
+}
+
+// Number of characters of the decimal representation of n.
+inline std::size_t count_digits(std::size_t n) noexcept
+{
+   std::size_t ret = 1;
+   for (; n >= 10; n /= 10)
+      ++ret;
+   return ret;
+}
+
+} // detail
+
 /** @brief Adds a bulk to the request.
  *  @ingroup any
  *
@@ -42,11 +99,7 @@ constexpr char separator[] = "\r\n";
 template <class Request>
 void to_bulk(Request& to, boost::string_view data)
 {
-   auto const str = std::to_string(data.size());
-
-   to += to_code(type::blob_string);
-   to.append(std::cbegin(str), std::cend(str));
-   to += separator;
+   detail::append_prefix(to, type::blob_string, data.size());
    to.append(std::cbegin(data), std::cend(data));
    to += separator;
 }
@@ -54,8 +107,8 @@ void to_bulk(Request& to, boost::string_view data)
 template <class Request, class T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
 void to_bulk(Request& to, T n)
 {
-   auto const s = std::to_string(n);
-   to_bulk(to, boost::string_view{s});
+   detail::integer_chars<T> const chars{n};
+   to_bulk(to, chars.view());
 }
 
 namespace detail {
@@ -88,9 +141,6 @@ struct add_bulk_impl<boost::hana::tuple<Ts...>> {
    {
       using boost::hana::for_each;
 
-      // Fold expressions is C++17 so we use hana.
-      //(resp3::add_bulk(*request_, args), ...);
-
       for_each(from, [&](auto const& e) {
          using namespace aedis::resp3;
          to_bulk(to, e);
@@ -109,11 +159,7 @@ struct add_bulk_impl<boost::hana::tuple<Ts...>> {
 template <class Request>
 void add_header(Request& to, type t, std::size_t size)
 {
-   auto const str = std::to_string(size);
-
-   to += to_code(t);
-   to.append(std::cbegin(str), std::cend(str));
-   to += separator;
+   detail::append_prefix(to, t, size);
 }
 
 /* Adds a rep3 bulk to the request.
@@ -126,6 +172,50 @@ void add_bulk(Request& to, T const& data)
    detail::add_bulk_impl<T>::add(to, data);
 }
 
+namespace detail {
+
+/* The number of bytes of an argument once encoded, zero when it is
+ * not known i.e. for types serialized by a user to_bulk.
+ */
+template <class T, class = void>
+struct bulk_size_impl {
+   static std::size_t size(T const&) noexcept { return 0; }
+};
+
+template <class T>
+struct bulk_size_impl<T, typename std::enable_if<std::is_convertible<T const&, boost::string_view>::value>::type> {
+   static std::size_t size(T const& data) noexcept
+   {
+      auto const n = boost::string_view{data}.size();
+      return 1 + count_digits(n) + 2 + n + 2;
+   }
+};
+
+template <class T>
+struct bulk_size_impl<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+   static std::size_t size(T) noexcept
+   {
+      // An upper bound.
+      auto constexpr n = integer_chars<T>::max_size;
+      return 1 + count_digits(n) + 2 + n + 2;
+   }
+};
+
+template <class U, class V>
+struct bulk_size_impl<std::pair<U, V>> {
+   static std::size_t size(std::pair<U, V> const& p) noexcept
+      { return bulk_size_impl<U>::size(p.first) + bulk_size_impl<V>::size(p.second); }
+};
+
+template <class T>
+std::size_t bulk_size(T const& data) noexcept
+   { return bulk_size_impl<T>::size(data); }
+
+inline std::size_t header_size(std::size_t size) noexcept
+   { return 1 + count_digits(size) + 2; }
+
+} // detail
+
 template <class>
 struct bulk_counter;
 
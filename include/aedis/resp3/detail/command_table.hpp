@@ -0,0 +1,192 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_DETAIL_COMMAND_TABLE_HPP
+#define AEDIS_RESP3_DETAIL_COMMAND_TABLE_HPP
+
+/* The commands known at compile time, taken from the output of
+ * COMMAND INFO of Redis 7.0. Each entry is
+ *
+ *    X(id, name, arity, first key, last key, key step, kind)
+ *
+ * where arity counts the command name and is negative when it is a
+ * minimum, a last key of -1 means the last argument and a first key of
+ * 0 that the command has no key or that its keys are given by other
+ * arguments e.g. EVAL. The kind is a command_kind, pubsub for commands
+ * of the pubsub category and subscribe for those whose response is a
+ * push. Containers like CLIENT are listed without their subcommands.
+ * Keep the entries sorted by name.
+ *
+ * test_command_info_capture in tests/low_level.cpp compares the table
+ * with tests/redis-6.2.14-command-info.resp, the reply of Redis 6.2.14
+ * to COMMAND INFO, where only the commands added or changed in 7.0
+ * differ. test_command_info in tests/connection.cpp compares it with
+ * COMMAND INFO of the server the tests run against, which must be 7.0
+ * or later to pass.
+ */
+#define AEDIS_RESP3_COMMAND_TABLE(X) \
+   X(acl,              "ACL",              -2,  0,  0, 0, other) \
+   X(append,           "APPEND",            3,  1,  1, 1, write) \
+   X(auth,             "AUTH",             -2,  0,  0, 0, other) \
+   X(bgsave,           "BGSAVE",           -1,  0,  0, 0, other) \
+   X(bitcount,         "BITCOUNT",         -2,  1,  1, 1, readonly) \
+   X(blpop,            "BLPOP",            -3,  1, -2, 1, write) \
+   X(brpop,            "BRPOP",            -3,  1, -2, 1, write) \
+   X(client,           "CLIENT",           -2,  0,  0, 0, other) \
+   X(cluster,          "CLUSTER",          -2,  0,  0, 0, other) \
+   X(command,          "COMMAND",          -1,  0,  0, 0, other) \
+   X(config,           "CONFIG",           -2,  0,  0, 0, other) \
+   X(copy,             "COPY",             -3,  1,  2, 1, write) \
+   X(dbsize,           "DBSIZE",            1,  0,  0, 0, readonly) \
+   X(decr,             "DECR",              2,  1,  1, 1, write) \
+   X(decrby,           "DECRBY",            3,  1,  1, 1, write) \
+   X(del,              "DEL",              -2,  1, -1, 1, write) \
+   X(discard,          "DISCARD",           1,  0,  0, 0, other) \
+   X(dump,             "DUMP",              2,  1,  1, 1, readonly) \
+   X(echo,             "ECHO",              2,  0,  0, 0, other) \
+   X(eval,             "EVAL",             -3,  0,  0, 0, other) \
+   X(evalsha,          "EVALSHA",          -3,  0,  0, 0, other) \
+   X(evalsha_ro,       "EVALSHA_RO",       -3,  0,  0, 0, readonly) \
+   X(eval_ro,          "EVAL_RO",          -3,  0,  0, 0, readonly) \
+   X(exec,             "EXEC",              1,  0,  0, 0, other) \
+   X(exists,           "EXISTS",           -2,  1, -1, 1, readonly) \
+   X(expire,           "EXPIRE",           -3,  1,  1, 1, write) \
+   X(expireat,         "EXPIREAT",         -3,  1,  1, 1, write) \
+   X(expiretime,       "EXPIRETIME",        2,  1,  1, 1, readonly) \
+   X(fcall,            "FCALL",            -3,  0,  0, 0, other) \
+   X(fcall_ro,         "FCALL_RO",         -3,  0,  0, 0, readonly) \
+   X(flushall,         "FLUSHALL",         -1,  0,  0, 0, write) \
+   X(flushdb,          "FLUSHDB",          -1,  0,  0, 0, write) \
+   X(function,         "FUNCTION",         -2,  0,  0, 0, other) \
+   X(geoadd,           "GEOADD",           -5,  1,  1, 1, write) \
+   X(get,              "GET",               2,  1,  1, 1, readonly) \
+   X(getbit,           "GETBIT",            3,  1,  1, 1, readonly) \
+   X(getdel,           "GETDEL",            2,  1,  1, 1, write) \
+   X(getex,            "GETEX",            -2,  1,  1, 1, write) \
+   X(getrange,         "GETRANGE",          4,  1,  1, 1, readonly) \
+   X(getset,           "GETSET",            3,  1,  1, 1, write) \
+   X(hdel,             "HDEL",             -3,  1,  1, 1, write) \
+   X(hello,            "HELLO",            -1,  0,  0, 0, other) \
+   X(hexists,          "HEXISTS",           3,  1,  1, 1, readonly) \
+   X(hget,             "HGET",              3,  1,  1, 1, readonly) \
+   X(hgetall,          "HGETALL",           2,  1,  1, 1, readonly) \
+   X(hincrby,          "HINCRBY",           4,  1,  1, 1, write) \
+   X(hincrbyfloat,     "HINCRBYFLOAT",      4,  1,  1, 1, write) \
+   X(hkeys,            "HKEYS",             2,  1,  1, 1, readonly) \
+   X(hlen,             "HLEN",              2,  1,  1, 1, readonly) \
+   X(hmget,            "HMGET",            -3,  1,  1, 1, readonly) \
+   X(hmset,            "HMSET",            -4,  1,  1, 1, write) \
+   X(hscan,            "HSCAN",            -3,  1,  1, 1, readonly) \
+   X(hset,             "HSET",             -4,  1,  1, 1, write) \
+   X(hsetnx,           "HSETNX",            4,  1,  1, 1, write) \
+   X(hstrlen,          "HSTRLEN",           3,  1,  1, 1, readonly) \
+   X(hvals,            "HVALS",             2,  1,  1, 1, readonly) \
+   X(incr,             "INCR",              2,  1,  1, 1, write) \
+   X(incrby,           "INCRBY",            3,  1,  1, 1, write) \
+   X(incrbyfloat,      "INCRBYFLOAT",       3,  1,  1, 1, write) \
+   X(info,             "INFO",             -1,  0,  0, 0, other) \
+   X(keys,             "KEYS",              2,  0,  0, 0, readonly) \
+   X(latency,          "LATENCY",          -2,  0,  0, 0, other) \
+   X(lindex,           "LINDEX",            3,  1,  1, 1, readonly) \
+   X(linsert,          "LINSERT",           5,  1,  1, 1, write) \
+   X(llen,             "LLEN",              2,  1,  1, 1, readonly) \
+   X(lmove,            "LMOVE",             5,  1,  2, 1, write) \
+   X(lpop,             "LPOP",             -2,  1,  1, 1, write) \
+   X(lpos,             "LPOS",             -3,  1,  1, 1, readonly) \
+   X(lpush,            "LPUSH",            -3,  1,  1, 1, write) \
+   X(lrange,           "LRANGE",            4,  1,  1, 1, readonly) \
+   X(lrem,             "LREM",              4,  1,  1, 1, write) \
+   X(lset,             "LSET",              4,  1,  1, 1, write) \
+   X(ltrim,            "LTRIM",             4,  1,  1, 1, write) \
+   X(memory,           "MEMORY",           -2,  0,  0, 0, other) \
+   X(mget,             "MGET",             -2,  1, -1, 1, readonly) \
+   X(monitor,          "MONITOR",           1,  0,  0, 0, other) \
+   X(move,             "MOVE",              3,  1,  1, 1, write) \
+   X(mset,             "MSET",             -3,  1, -1, 2, write) \
+   X(multi,            "MULTI",             1,  0,  0, 0, other) \
+   X(object,           "OBJECT",           -2,  0,  0, 0, other) \
+   X(persist,          "PERSIST",           2,  1,  1, 1, write) \
+   X(pexpire,          "PEXPIRE",          -3,  1,  1, 1, write) \
+   X(pfadd,            "PFADD",            -2,  1,  1, 1, write) \
+   X(pfcount,          "PFCOUNT",          -2,  1, -1, 1, readonly) \
+   X(ping,             "PING",             -1,  0,  0, 0, other) \
+   X(psubscribe,       "PSUBSCRIBE",       -2,  0,  0, 0, subscribe) \
+   X(pttl,             "PTTL",              2,  1,  1, 1, readonly) \
+   X(publish,          "PUBLISH",           3,  0,  0, 0, pubsub) \
+   X(punsubscribe,     "PUNSUBSCRIBE",     -1,  0,  0, 0, subscribe) \
+   X(quit,             "QUIT",             -1,  0,  0, 0, other) \
+   X(randomkey,        "RANDOMKEY",         1,  0,  0, 0, readonly) \
+   X(readonly,         "READONLY",          1,  0,  0, 0, other) \
+   X(readwrite,        "READWRITE",         1,  0,  0, 0, other) \
+   X(rename,           "RENAME",            3,  1,  2, 1, write) \
+   X(reset,            "RESET",             1,  0,  0, 0, other) \
+   X(restore,          "RESTORE",          -4,  1,  1, 1, write) \
+   X(role,             "ROLE",              1,  0,  0, 0, other) \
+   X(rpop,             "RPOP",             -2,  1,  1, 1, write) \
+   X(rpoplpush,        "RPOPLPUSH",         3,  1,  2, 1, write) \
+   X(rpush,            "RPUSH",            -3,  1,  1, 1, write) \
+   X(sadd,             "SADD",             -3,  1,  1, 1, write) \
+   X(save,             "SAVE",              1,  0,  0, 0, other) \
+   X(scan,             "SCAN",             -2,  0,  0, 0, readonly) \
+   X(scard,            "SCARD",             2,  1,  1, 1, readonly) \
+   X(script,           "SCRIPT",           -2,  0,  0, 0, other) \
+   X(select,           "SELECT",            2,  0,  0, 0, other) \
+   X(sentinel,         "SENTINEL",         -2,  0,  0, 0, other) \
+   X(set,              "SET",              -3,  1,  1, 1, write) \
+   X(setbit,           "SETBIT",            4,  1,  1, 1, write) \
+   X(setex,            "SETEX",             4,  1,  1, 1, write) \
+   X(setnx,            "SETNX",             3,  1,  1, 1, write) \
+   X(setrange,         "SETRANGE",          4,  1,  1, 1, write) \
+   X(shutdown,         "SHUTDOWN",         -1,  0,  0, 0, other) \
+   X(sinter,           "SINTER",           -2,  1, -1, 1, readonly) \
+   X(sismember,        "SISMEMBER",         3,  1,  1, 1, readonly) \
+   X(slowlog,          "SLOWLOG",          -2,  0,  0, 0, other) \
+   X(smembers,         "SMEMBERS",          2,  1,  1, 1, readonly) \
+   X(smove,            "SMOVE",             4,  1,  2, 1, write) \
+   X(sort,             "SORT",             -2,  1,  1, 1, write) \
+   X(spop,             "SPOP",             -2,  1,  1, 1, write) \
+   X(spublish,         "SPUBLISH",          3,  1,  1, 1, pubsub) \
+   X(srandmember,      "SRANDMEMBER",      -2,  1,  1, 1, readonly) \
+   X(srem,             "SREM",             -3,  1,  1, 1, write) \
+   X(sscan,            "SSCAN",            -3,  1,  1, 1, readonly) \
+   X(ssubscribe,       "SSUBSCRIBE",       -2,  1, -1, 1, subscribe) \
+   X(strlen,           "STRLEN",            2,  1,  1, 1, readonly) \
+   X(subscribe,        "SUBSCRIBE",        -2,  0,  0, 0, subscribe) \
+   X(sunion,           "SUNION",           -2,  1, -1, 1, readonly) \
+   X(sunsubscribe,     "SUNSUBSCRIBE",     -1,  1, -1, 1, subscribe) \
+   X(swapdb,           "SWAPDB",            3,  0,  0, 0, write) \
+   X(time,             "TIME",              1,  0,  0, 0, other) \
+   X(touch,            "TOUCH",            -2,  1, -1, 1, readonly) \
+   X(ttl,              "TTL",               2,  1,  1, 1, readonly) \
+   X(type,             "TYPE",              2,  1,  1, 1, readonly) \
+   X(unlink,           "UNLINK",           -2,  1, -1, 1, write) \
+   X(unsubscribe,      "UNSUBSCRIBE",      -1,  0,  0, 0, subscribe) \
+   X(unwatch,          "UNWATCH",           1,  0,  0, 0, other) \
+   X(wait,             "WAIT",              3,  0,  0, 0, other) \
+   X(watch,            "WATCH",            -2,  1, -1, 1, other) \
+   X(xack,             "XACK",             -4,  1,  1, 1, write) \
+   X(xadd,             "XADD",             -5,  1,  1, 1, write) \
+   X(xdel,             "XDEL",             -3,  1,  1, 1, write) \
+   X(xgroup,           "XGROUP",           -2,  0,  0, 0, other) \
+   X(xlen,             "XLEN",              2,  1,  1, 1, readonly) \
+   X(xrange,           "XRANGE",           -4,  1,  1, 1, readonly) \
+   X(xread,            "XREAD",            -4,  0,  0, 0, readonly) \
+   X(xreadgroup,       "XREADGROUP",       -7,  0,  0, 0, write) \
+   X(xtrim,            "XTRIM",            -4,  1,  1, 1, write) \
+   X(zadd,             "ZADD",             -4,  1,  1, 1, write) \
+   X(zcard,            "ZCARD",             2,  1,  1, 1, readonly) \
+   X(zcount,           "ZCOUNT",            4,  1,  1, 1, readonly) \
+   X(zincrby,          "ZINCRBY",           4,  1,  1, 1, write) \
+   X(zrange,           "ZRANGE",           -4,  1,  1, 1, readonly) \
+   X(zrangebyscore,    "ZRANGEBYSCORE",    -4,  1,  1, 1, readonly) \
+   X(zrank,            "ZRANK",             3,  1,  1, 1, readonly) \
+   X(zrem,             "ZREM",             -3,  1,  1, 1, write) \
+   X(zremrangebyscore, "ZREMRANGEBYSCORE",  4,  1,  1, 1, write) \
+   X(zrevrange,        "ZREVRANGE",        -4,  1,  1, 1, readonly) \
+   X(zscan,            "ZSCAN",            -3,  1,  1, 1, readonly) \
+   X(zscore,           "ZSCORE",            3,  1,  1, 1, readonly)
+
+#endif // AEDIS_RESP3_DETAIL_COMMAND_TABLE_HPP
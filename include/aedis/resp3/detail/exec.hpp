@@ -19,6 +19,7 @@
 #include <aedis/error.hpp>
 #include <aedis/resp3/read.hpp>
 #include <aedis/resp3/request.hpp>
+#include <aedis/resp3/write.hpp>
 
 namespace aedis {
 namespace resp3 {
@@ -48,11 +49,7 @@ struct exec_op {
       reenter (coro) for (;;)
       {
          if (req) {
-            yield
-            boost::asio::async_write(
-               *socket,
-               boost::asio::buffer(req->payload()),
-               std::move(self));
+            yield resp3::async_write(*socket, *req, std::move(self));
 
             if (ec || n_cmds == 0) {
                self.complete(ec, n);
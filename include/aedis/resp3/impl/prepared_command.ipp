@@ -0,0 +1,56 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <aedis/resp3/prepared_command.hpp>
+#include <aedis/resp3/request.hpp>
+
+namespace aedis {
+namespace resp3 {
+
+prepared_command::prepared_command(boost::string_view format)
+{
+   std::vector<boost::string_view> args;
+   while (!format.empty()) {
+      auto const pos = format.find(' ');
+      auto const arg = format.substr(0, pos);
+      if (!arg.empty())
+         args.push_back(arg);
+
+      if (pos == boost::string_view::npos)
+         break;
+
+      format.remove_prefix(pos + 1);
+   }
+
+   BOOST_ASSERT_MSG(!args.empty(), "Empty command.");
+
+   std::string literal;
+   add_header(literal, type::array, args.size());
+   for (auto const& arg: args) {
+      auto const pos = arg.find("{}");
+      if (pos == boost::string_view::npos) {
+         to_bulk(literal, arg);
+         continue;
+      }
+
+      BOOST_ASSERT_MSG(arg.find("{}", pos + 2) == boost::string_view::npos, "More than one slot in an argument.");
+
+      // The slot without its header and value.
+      static_size_ += literal.size() + arg.size();
+      slots_.push_back({std::move(literal), std::string{arg.substr(0, pos)}, std::string{arg.substr(pos + 2)}});
+      literal.clear();
+   }
+
+   static_size_ += literal.size();
+   tail_ = std::move(literal);
+
+   // A command in a slot is assumed to have a response.
+   if (args.front().find("{}") == boost::string_view::npos)
+      has_response_ = !detail::has_push_response(args.front());
+}
+
+} // resp3
+} // aedis
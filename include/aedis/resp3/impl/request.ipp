@@ -12,10 +12,8 @@ namespace detail {
 
 bool has_push_response(boost::string_view cmd)
 {
-   if (cmd == "SUBSCRIBE") return true;
-   if (cmd == "PSUBSCRIBE") return true;
-   if (cmd == "UNSUBSCRIBE") return true;
-   return false;
+   auto const* info = find_command(cmd);
+   return info != nullptr && info->has_push_response();
 }
 
 } // detail
@@ -0,0 +1,58 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <aedis/resp3/request_pool.hpp>
+
+namespace aedis {
+namespace resp3 {
+
+void request_pool::deleter::operator()(request* req) const noexcept
+{
+   if (pool_ && owner_ == std::this_thread::get_id())
+      pool_->release(req);
+   else
+      delete req;
+}
+
+request_pool::request_pool(std::size_t max_size, std::size_t max_capacity)
+: max_size_{max_size}
+, max_capacity_{max_capacity}
+{
+   // So that release doesn't allocate.
+   free_.reserve(max_size_);
+}
+
+auto request_pool::acquire() -> pointer
+{
+   if (free_.empty())
+      return pointer{new request, deleter{this}};
+
+   auto* req = free_.back().release();
+   free_.pop_back();
+   return pointer{req, deleter{this}};
+}
+
+void request_pool::release(request* req) noexcept
+{
+   std::unique_ptr<request> p{req};
+   if (free_.size() >= max_size_ || p->capacity() > max_capacity_)
+      return;
+
+   p->clear();
+   p->close_on_run_completion = false;
+   p->lane = priority_lane::normal;
+   p->tenant = 0;
+   free_.push_back(std::move(p));
+}
+
+request_pool& this_thread_request_pool()
+{
+   thread_local request_pool pool;
+   return pool;
+}
+
+} // resp3
+} // aedis
@@ -0,0 +1,160 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_PREPARED_COMMAND_HPP
+#define AEDIS_RESP3_PREPARED_COMMAND_HPP
+
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include <boost/assert.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include <aedis/resp3/compose.hpp>
+
+namespace aedis {
+namespace resp3 {
+namespace detail {
+
+template <class T>
+auto slot_value(T const& arg)
+{
+   if constexpr (std::is_integral<T>::value)
+      return integer_chars<T>{arg};
+   else
+      return boost::string_view{arg};
+}
+
+template <class T>
+boost::string_view slot_view(integer_chars<T> const& chars) noexcept
+   { return chars.view(); }
+
+inline boost::string_view slot_view(boost::string_view v) noexcept
+   { return v; }
+
+} // detail
+
+/** @brief A command whose constant parts are encoded only once.
+ *  \ingroup any
+ *
+ *  The command is described by a format where arguments are separated
+ *  by spaces and \c {} marks the slots that are filled on every use,
+ *  also inside an argument. For example
+ *
+ *  @code
+ *  prepared_command const hincrby{"HINCRBY stats:{} field {}"};
+ *
+ *  request req;
+ *  req.push(hincrby, user_id, 1);
+ *  @endcode
+ *
+ *  is equivalent to <tt>req.push("HINCRBY", "stats:" + user_id, "field", 1)</tt>,
+ *  but only the slots are encoded, the rest is copied from the
+ *  encoding done by the constructor. Arguments that contain spaces
+ *  must be passed in slots. Slots accept strings and integers.
+ */
+class prepared_command {
+public:
+   /** \brief Constructor.
+    *
+    *  \param format The command and its arguments, at most one \c {} per argument.
+    */
+   explicit prepared_command(boost::string_view format);
+
+   /// Returns the number of slots.
+   std::size_t slots() const noexcept { return slots_.size(); }
+
+   /// Whether the command has a response, see request::size.
+   bool has_response() const noexcept { return has_response_; }
+
+   /// Returns the size of the encoding without the slots.
+   std::size_t static_size() const noexcept { return static_size_; }
+
+   /** \brief Appends the command to a payload.
+    *
+    *  \param to The payload.
+    *  \param args One argument per slot.
+    *  \throws std::invalid_argument if the number of arguments and
+    *  slots differ, the payload is then left unchanged.
+    */
+   template <class Payload, class... Ts>
+   void encode(Payload& to, Ts const&... args) const
+   {
+      if (sizeof...(Ts) != slots_.size())
+         throw std::invalid_argument{"prepared_command: Number of arguments and slots differ."};
+
+      // Integers are formatted first so that the size is known.
+      auto const values = std::make_tuple(detail::slot_value(args)...);
+      std::apply([&](auto const&... v) {
+         boost::string_view const views[] = {detail::slot_view(v)..., {}};
+         write(to, views);
+      }, values);
+   }
+
+private:
+   struct slot {
+      // The encoding of everything since the previous slot.
+      std::string literal;
+      std::string prefix;
+      std::string suffix;
+   };
+
+   static char* copy(char* p, boost::string_view s) noexcept
+   {
+      std::memcpy(p, s.data(), s.size());
+      return p + s.size();
+   }
+
+   // Resizes the payload once and copies the parts into it.
+   template <class Payload>
+   void write(Payload& to, boost::string_view const* values) const
+   {
+      auto size = static_size_;
+      for (std::size_t i = 0; i < slots_.size(); ++i) {
+         auto const n = slots_[i].prefix.size() + values[i].size() + slots_[i].suffix.size();
+         size += detail::header_size(n) + values[i].size();
+      }
+
+      auto const offset = to.size();
+      to.resize(offset + size);
+      auto* p = &to[offset];
+
+      for (std::size_t i = 0; i < slots_.size(); ++i) {
+         auto const& s = slots_[i];
+         auto const n = s.prefix.size() + values[i].size() + s.suffix.size();
+         auto const digits = detail::count_digits(n);
+
+         p = copy(p, s.literal);
+         *p++ = to_code(type::blob_string);
+         for (auto q = p + digits, m = n; q != p; m /= 10)
+            *--q = static_cast<char>('0' + m % 10);
+         p += digits;
+         *p++ = '\r';
+         *p++ = '\n';
+         p = copy(p, s.prefix);
+         p = copy(p, values[i]);
+         p = copy(p, s.suffix);
+         *p++ = '\r';
+         *p++ = '\n';
+      }
+
+      copy(p, tail_);
+   }
+
+   std::vector<slot> slots_;
+   std::string tail_;
+   std::size_t static_size_ = 0;
+   bool has_response_ = true;
+};
+
+} // resp3
+} // aedis
+
+#endif // AEDIS_RESP3_PREPARED_COMMAND_HPP
@@ -7,13 +7,21 @@
 #ifndef AEDIS_RESP3_REQUEST_HPP
 #define AEDIS_RESP3_REQUEST_HPP
 
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+#include <aedis/resp3/command.hpp>
 #include <aedis/resp3/compose.hpp>
-#include <boost/hana.hpp>
+#include <aedis/resp3/prepared_command.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/core/span.hpp>
 #include <boost/utility/string_view.hpp>
 
-// NOTE: Consider detecting tuples in the type in the parameter pack
-// to calculate the header size correctly.
-//
 // NOTE: For some commands like hset it would be a good idea to assert
 // the value type is a pair.
 
@@ -25,6 +33,86 @@ bool has_push_response(boost::string_view cmd);
 
 } // detail
 
+/** @brief The priority lane of a request.
+ *  \ingroup any
+ *
+ *  The connection writes the requests waiting to be written in lane
+ *  order, requests that were already written are not affected. The
+ *  requests of all lanes may be coalesced in the same write, see
+ *  connection::config::max_batch_commands to bound it.
+ */
+enum class priority_lane : std::uint8_t
+{
+   /// Written before all others, used by the health checks.
+   high = 0,
+   /// The default.
+   normal = 1,
+   /// Written after the waiting requests of the other lanes.
+   low = 2,
+};
+
+/** @brief A request argument that refers to memory of the caller.
+ *  \ingroup any
+ *
+ *  See resp3::external.
+ */
+struct external_arg {
+   /// The bytes of the argument.
+   boost::asio::const_buffer data;
+
+   /// Keeps the memory alive, optional.
+   std::shared_ptr<void const> owner;
+};
+
+/** @brief Passes an argument to a request without copying it.
+ *  \ingroup any
+ *
+ *  The bytes are not copied into the payload but written with a
+ *  gather write, which saves two copies of large values. For example
+ *
+ *  @code
+ *  req.push("SET", "key", external(boost::asio::buffer(value)));
+ *  @endcode
+ *
+ *  The memory must stay valid until the request is executed, or be
+ *  owned by \c owner, e.g. a \c std::shared_ptr whose deleter unmaps
+ *  a file, which the connection also keeps while writing in case the
+ *  request is canceled meanwhile. Requests with external arguments
+ *  must be written with request::for_each_buffer, not only their
+ *  payload.
+ *
+ *  \param data The bytes of the argument.
+ *  \param owner Optional owner of the bytes, kept by the request.
+ */
+inline external_arg
+external(
+   boost::asio::const_buffer data,
+   std::shared_ptr<void const> owner = nullptr)
+{
+   return {data, std::move(owner)};
+}
+
+/** @brief An external argument and where it goes in the payload.
+ *  \ingroup any
+ */
+struct external_segment {
+   /// The offset in the payload where the bytes are inserted.
+   std::size_t offset;
+
+   /// The argument.
+   external_arg arg;
+};
+
+namespace detail {
+
+template <>
+struct bulk_size_impl<external_arg> {
+   static std::size_t size(external_arg const& arg) noexcept
+      { return header_size(arg.data.size()) + 2; }
+};
+
+} // detail
+
 /** @brief Creates Redis requests.
  *  \ingroup any
  *  
@@ -42,21 +130,103 @@ bool has_push_response(boost::string_view cmd);
  *  co_await async_write(socket, buffer(r));
  *  @endcode
  *
+ *  The payload is stored in a \c std::basic_string with the given
+ *  allocator, the external arguments in a \c std::vector with the
+ *  same allocator rebound. Commands do not fit in the small string buffer of the
+ *  standard libraries, e.g. a \c GET is 22 bytes, so requests that
+ *  must not allocate either reuse their capacity, see request_pool,
+ *  or take their memory from a buffer of the caller, for example
+ *
+ *  @code
+ *  char buffer[512];
+ *  std::pmr::monotonic_buffer_resource resource{buffer, sizeof buffer};
+ *  basic_request<std::pmr::polymorphic_allocator<char>> r{&resource};
+ *  @endcode
+ *
+ *  The connection executes requests of any allocator, see
+ *  request_view.
+ *
  *  \remarks  Non-string types will be converted to string by using \c
  *  to_bulk, which must be made available over ADL.
  */
-class request {
+template <class Allocator = std::allocator<char>>
+class basic_request {
 public:
+   /// The allocator type.
+   using allocator_type = Allocator;
+
+   /// The type of the payload.
+   using payload_type = std::basic_string<char, std::char_traits<char>, Allocator>;
+
+   /// An external argument and where it goes in the payload.
+   using external_segment = resp3::external_segment;
+
+   /// The type of the external arguments.
+   using externals_type =
+      std::vector<
+         external_segment,
+         typename std::allocator_traits<Allocator>::template rebind_alloc<external_segment>
+      >;
+
+   /// Default constructor.
+   basic_request() = default;
+
+   /// Constructor.
+   explicit basic_request(allocator_type const& alloc)
+   : payload_{alloc}
+   , externals_{typename externals_type::allocator_type{alloc}}
+   { }
+
+   /// Returns the allocator.
+   allocator_type get_allocator() const { return payload_.get_allocator(); }
+
    //// Returns the number of commands contained in this request.
    std::size_t size() const noexcept { return commands_;};
 
    // Returns the request payload.
    auto const& payload() const noexcept { return payload_;}
 
+   /// Reserves memory for a payload of \c n bytes.
+   void reserve(std::size_t n) { payload_.reserve(n); }
+
+   /// Returns the size of the memory allocated for the payload.
+   std::size_t capacity() const noexcept { return payload_.capacity(); }
+
+   /// Returns the external arguments in the order they appear.
+   externals_type const& externals() const noexcept { return externals_; }
+
+   /// Returns the number of bytes of external arguments.
+   std::size_t external_size() const noexcept
+   {
+      std::size_t ret = 0;
+      for (auto const& e: externals_)
+         ret += e.arg.data.size();
+      return ret;
+   }
+
+   /** @brief Calls \c f with the buffers to write in order.
+    *
+    *  That is the payload interleaved with the external arguments, or
+    *  only the payload when there are none.
+    */
+   template <class Function>
+   void for_each_buffer(Function f) const
+   {
+      std::size_t pos = 0;
+      for (auto const& e: externals_) {
+         f(boost::asio::buffer(payload_.data() + pos, e.offset - pos));
+         f(e.arg.data);
+         pos = e.offset;
+      }
+
+      f(boost::asio::buffer(payload_.data() + pos, payload_.size() - pos));
+   }
+
    /// Clears the request preserving allocated memory.
    void clear()
    {
       payload_.clear();
+      externals_.clear();
       commands_ = 0;
    }
 
@@ -73,24 +243,168 @@ public:
     *  expiration of 2 seconds.
     *
     *  \param cmd The command e.g redis or sentinel command.
-    *  \param args Command arguments.
+    *  \param args Command arguments, a \c std::pair is two arguments.
     */
    template <class... Ts>
    void push(boost::string_view cmd, Ts const&... args)
    {
-      using boost::hana::for_each;
-      using boost::hana::make_tuple;
-      using resp3::type;
-
-      auto constexpr pack_size = sizeof...(Ts);
-      resp3::add_header(payload_, type::array, 1 + pack_size);
-      resp3::add_bulk(payload_, cmd);
-      resp3::add_bulk(payload_, make_tuple(args...));
+      add_command(cmd, args...);
 
       if (!detail::has_push_response(cmd))
          ++commands_;
    }
 
+   /** @brief Appends a command known at compile time.
+    *
+    *  The name of the command and whether it has a response are
+    *  resolved at compile time and the number of arguments is
+    *  checked against its arity, for example
+    *
+    *  \code
+    *  request req;
+    *  req.push<command::hincrby>("key", "field", 1);
+    *  \endcode
+    *
+    *  See also the builders below e.g. \c req.hgetall("key").
+    *
+    *  \param args Command arguments.
+    */
+   template <command Cmd, class... Ts>
+   void push(Ts const&... args)
+   {
+      constexpr auto const& cmd = info(Cmd);
+      static_assert(cmd.accepts(1 + bulk_count<Ts...>), "Wrong number of arguments for the command.");
+
+      add_command(cmd.name, args...);
+
+      if constexpr (!cmd.has_push_response())
+         ++commands_;
+   }
+
+   /// Appends \c GET.
+   template <class Key>
+   void get(Key const& key)
+      { push<command::get>(key); }
+
+   /// Appends \c SET, options like "EX" and 60 follow the value.
+   template <class Key, class Value, class... Options>
+   void set(Key const& key, Value const& value, Options const&... options)
+      { push<command::set>(key, value, options...); }
+
+   /// Appends \c DEL.
+   template <class Key, class... Keys>
+   void del(Key const& key, Keys const&... keys)
+      { push<command::del>(key, keys...); }
+
+   /// Appends \c EXISTS.
+   template <class Key, class... Keys>
+   void exists(Key const& key, Keys const&... keys)
+      { push<command::exists>(key, keys...); }
+
+   /// Appends \c EXPIRE.
+   template <class Key>
+   void expire(Key const& key, std::int64_t seconds)
+      { push<command::expire>(key, seconds); }
+
+   /// Appends \c INCR.
+   template <class Key>
+   void incr(Key const& key)
+      { push<command::incr>(key); }
+
+   /// Appends \c INCRBY.
+   template <class Key>
+   void incrby(Key const& key, std::int64_t n)
+      { push<command::incrby>(key, n); }
+
+   /// Appends \c DECR.
+   template <class Key>
+   void decr(Key const& key)
+      { push<command::decr>(key); }
+
+   /// Appends \c HGET.
+   template <class Key, class Field>
+   void hget(Key const& key, Field const& field)
+      { push<command::hget>(key, field); }
+
+   /// Appends \c HSET, more fields and values may follow.
+   template <class Key, class Field, class Value, class... FieldsValues>
+   void hset(Key const& key, Field const& field, Value const& value, FieldsValues const&... more)
+   {
+      static_assert(bulk_count<Field, Value, FieldsValues...> % 2 == 0, "HSET expects pairs of fields and values.");
+      push<command::hset>(key, field, value, more...);
+   }
+
+   /// Appends \c HGETALL.
+   template <class Key>
+   void hgetall(Key const& key)
+      { push<command::hgetall>(key); }
+
+   /// Appends \c HDEL.
+   template <class Key, class Field, class... Fields>
+   void hdel(Key const& key, Field const& field, Fields const&... fields)
+      { push<command::hdel>(key, field, fields...); }
+
+   /// Appends \c HINCRBY.
+   template <class Key, class Field>
+   void hincrby(Key const& key, Field const& field, std::int64_t n)
+      { push<command::hincrby>(key, field, n); }
+
+   /// Appends \c LPUSH.
+   template <class Key, class Value, class... Values>
+   void lpush(Key const& key, Value const& value, Values const&... values)
+      { push<command::lpush>(key, value, values...); }
+
+   /// Appends \c RPUSH.
+   template <class Key, class Value, class... Values>
+   void rpush(Key const& key, Value const& value, Values const&... values)
+      { push<command::rpush>(key, value, values...); }
+
+   /// Appends \c LRANGE.
+   template <class Key>
+   void lrange(Key const& key, std::int64_t start, std::int64_t stop)
+      { push<command::lrange>(key, start, stop); }
+
+   /// Appends \c SADD.
+   template <class Key, class Member, class... Members>
+   void sadd(Key const& key, Member const& member, Members const&... members)
+      { push<command::sadd>(key, member, members...); }
+
+   /// Appends \c SMEMBERS.
+   template <class Key>
+   void smembers(Key const& key)
+      { push<command::smembers>(key); }
+
+   /// Appends \c PUBLISH.
+   template <class Channel, class Message>
+   void publish(Channel const& channel, Message const& message)
+      { push<command::publish>(channel, message); }
+
+   /** @brief Appends a prepared command to the end of the request.
+    *
+    *  For example
+    *
+    *  \code
+    *  prepared_command const hincrby{"HINCRBY stats:{} field {}"};
+    *
+    *  request req;
+    *  req.push(hincrby, "user1", 1);
+    *  \endcode
+    *
+    *  \param cmd The prepared command.
+    *  \param args One argument per slot of the command.
+    *  \throws std::invalid_argument if the number of arguments and
+    *  slots differ.
+    */
+   template <class... Ts>
+   void push(prepared_command const& cmd, Ts const&... args)
+   {
+      grow(cmd.static_size() + (std::size_t{0} + ... + detail::bulk_size(args)));
+      cmd.encode(payload_, args...);
+
+      if (cmd.has_response())
+         ++commands_;
+   }
+
    /** @brief Appends a new command to the end of the request.
     *  
     *  This overload is useful for commands that have a key and have a
@@ -106,32 +420,25 @@ public:
     *  request req;
     *  req.push_range2("HSET", "key", std::cbegin(map), std::cend(map));
     *  @endcode
-    *  
+    *
+    *  Input iterators are supported, the header is then written after
+    *  the elements were counted.
+    *
     *  \param cmd The command e.g. Redis or Sentinel command.
     *  \param key The command key.
     *  \param begin Iterator to the begin of the range.
     *  \param end Iterator to the end of the range.
     */
-   template <class Key, class ForwardIterator>
-   void push_range2(boost::string_view cmd, Key const& key, ForwardIterator begin, ForwardIterator end)
+   template <class Key, class Iterator>
+   void push_range2(boost::string_view cmd, Key const& key, Iterator begin, Iterator end)
    {
-      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
-      using resp3::type;
-
       if (begin == end)
          return;
 
-      auto constexpr size = resp3::bulk_counter<value_type>::size;
-      auto const distance = std::distance(begin, end);
-      resp3::add_header(payload_, type::array, 2 + size * distance);
-      resp3::add_bulk(payload_, cmd);
-      resp3::add_bulk(payload_, key);
-
-      for (; begin != end; ++begin)
-	 resp3::add_bulk(payload_, *begin);
-
-      if (!detail::has_push_response(cmd))
-         ++commands_;
+      if constexpr (is_forward_iterator<Iterator>::value)
+         push_sized_range(cmd, begin, end, key);
+      else
+         push_input_range(cmd, begin, end, key);
    }
 
    /** @brief Appends a new command to the end of the request.
@@ -147,29 +454,23 @@ public:
     *  req.push("SUBSCRIBE", std::cbegin(channels), std::cedn(channels));
     *  \endcode
     *
+    *  Input iterators are supported, the header is then written after
+    *  the elements were counted.
+    *
     *  \param cmd The Redis command
     *  \param begin Iterator to the begin of the range.
     *  \param end Iterator to the end of the range.
     */
-   template <class ForwardIterator>
-   void push_range2(boost::string_view cmd, ForwardIterator begin, ForwardIterator end)
+   template <class Iterator>
+   void push_range2(boost::string_view cmd, Iterator begin, Iterator end)
    {
-      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
-      using resp3::type;
-
       if (begin == end)
          return;
 
-      auto constexpr size = resp3::bulk_counter<value_type>::size;
-      auto const distance = std::distance(begin, end);
-      resp3::add_header(payload_, type::array, 1 + size * distance);
-      resp3::add_bulk(payload_, cmd);
-
-      for (; begin != end; ++begin)
-	 resp3::add_bulk(payload_, *begin);
-
-      if (!detail::has_push_response(cmd))
-         ++commands_;
+      if constexpr (is_forward_iterator<Iterator>::value)
+         push_sized_range(cmd, begin, end);
+      else
+         push_input_range(cmd, begin, end);
    }
 
    /** @brief Appends a new command to the end of the request.
@@ -203,13 +504,205 @@ public:
       push_range2(cmd, begin(range), end(range));
    }
 
+   /** @brief Appends the commands of another request.
+    *
+    *  \param other The request whose commands are appended, of any
+    *  allocator.
+    */
+   template <class OtherAllocator>
+   void append(basic_request<OtherAllocator> const& other)
+   {
+      for (auto const& e: other.externals())
+         externals_.push_back({payload_.size() + e.offset, e.arg});
+
+      payload_.append(other.payload().data(), other.payload().size());
+      commands_ += other.size();
+   }
+
    mutable bool close_on_run_completion = false;
 
+   /// The lane of the request, see connection::config::max_batch_commands.
+   priority_lane lane = priority_lane::normal;
+
+   /** @brief The tenant the request belongs to.
+    *
+    *  Requests of different tenants in the same lane are written in
+    *  weighted round-robin, see connection::config::tenant_weights.
+    */
+   std::size_t tenant = 0;
+
 private:
-   std::string payload_;
+   template <class Iterator>
+   using is_forward_iterator =
+      std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>;
+
+   // The number of bulk strings of the arguments, pairs are two.
+   template <class... Ts>
+   static constexpr std::size_t bulk_count = (std::size_t{0} + ... + resp3::bulk_counter<Ts>::size);
+
+   template <class... Ts>
+   void add_command(boost::string_view cmd, Ts const&... args)
+   {
+      auto constexpr count = 1 + bulk_count<Ts...>;
+      grow(detail::header_size(count) + detail::bulk_size(cmd) + (std::size_t{0} + ... + detail::bulk_size(args)));
+
+      resp3::add_header(payload_, type::array, count);
+      resp3::add_bulk(payload_, cmd);
+      (add_arg(args), ...);
+   }
+
+   template <class T>
+   void add_arg(T const& arg)
+   {
+      if constexpr (std::is_same<T, external_arg>::value) {
+         resp3::add_header(payload_, type::blob_string, arg.data.size());
+         externals_.push_back({payload_.size(), arg});
+         resp3::add_separator(payload_);
+      } else {
+         resp3::add_bulk(payload_, arg);
+      }
+   }
+
+   template <class ForwardIterator, class... Key>
+   void push_sized_range(boost::string_view cmd, ForwardIterator begin, ForwardIterator end, Key const&... key)
+   {
+      using value_type = typename std::iterator_traits<ForwardIterator>::value_type;
+
+      auto constexpr size = resp3::bulk_counter<value_type>::size;
+      std::size_t const count = 1 + sizeof...(Key) + size * std::distance(begin, end);
+      grow(detail::header_size(count) + detail::bulk_size(cmd) + (std::size_t{0} + ... + detail::bulk_size(key)) + range_size(begin, end));
+
+      resp3::add_header(payload_, type::array, count);
+      resp3::add_bulk(payload_, cmd);
+      (add_arg(key), ...);
+
+      for (; begin != end; ++begin)
+         add_arg(*begin);
+
+      if (!detail::has_push_response(cmd))
+         ++commands_;
+   }
+
+   /* The number of elements of an input range is only known after
+    * iterating over it, the header is inserted in front of them
+    * afterwards.
+    */
+   template <class InputIterator, class... Key>
+   void push_input_range(boost::string_view cmd, InputIterator begin, InputIterator end, Key const&... key)
+   {
+      using value_type = typename std::iterator_traits<InputIterator>::value_type;
+
+      auto const offset = payload_.size();
+      auto const first_external = externals_.size();
+      std::size_t count = 1 + sizeof...(Key);
+
+      resp3::add_bulk(payload_, cmd);
+      (add_arg(key), ...);
+      for (; begin != end; ++begin) {
+         add_arg(*begin);
+         count += resp3::bulk_counter<value_type>::size;
+      }
+
+      char header[detail::max_prefix_size];
+      auto const n = detail::format_prefix(header, type::array, count);
+      payload_.insert(offset, header, n);
+      for (auto i = first_external; i < externals_.size(); ++i)
+         externals_[i].offset += n;
+
+      if (!detail::has_push_response(cmd))
+         ++commands_;
+   }
+
+   template <class ForwardIterator>
+   static std::size_t range_size(ForwardIterator begin, ForwardIterator end) noexcept
+   {
+      std::size_t ret = 0;
+      for (; begin != end; ++begin)
+         ret += detail::bulk_size(*begin);
+      return ret;
+   }
+
+   // Reserves space for n more bytes at once, growing geometrically.
+   void grow(std::size_t n)
+   {
+      auto const needed = payload_.size() + n;
+      if (needed > payload_.capacity())
+         payload_.reserve((std::max)(needed, 2 * payload_.capacity()));
+   }
+
+   payload_type payload_;
+   externals_type externals_;
    std::size_t commands_ = 0;
 };
 
+/** @brief A request with the default allocator.
+ *  \ingroup any
+ */
+using request = basic_request<>;
+
+/** @brief Refers to a request of any allocator.
+ *  \ingroup any
+ *
+ *  The connection keeps views of the requests it executes and passes
+ *  them to its tracer. The request must outlive the view and must not
+ *  be modified meanwhile, its lane, tenant and
+ *  \c close_on_run_completion are copied on construction.
+ */
+class request_view {
+public:
+   /// Default constructor, refers to no request.
+   request_view() = default;
+
+   /// Constructor.
+   template <class Allocator>
+   request_view(basic_request<Allocator> const& req) noexcept
+   : lane{req.lane}
+   , tenant{req.tenant}
+   , close_on_run_completion{req.close_on_run_completion}
+   , id_{&req}
+   , payload_{req.payload().data(), req.payload().size()}
+   , externals_{req.externals().data(), req.externals().size()}
+   , size_{req.size()}
+   { }
+
+   /// Identifies the request, views of the same request have the same id.
+   void const* id() const noexcept { return id_; }
+
+   /// Returns the number of commands of the request.
+   std::size_t size() const noexcept { return size_; }
+
+   /// Returns the payload of the request.
+   boost::string_view payload() const noexcept { return payload_; }
+
+   /// Returns the external arguments in the order they appear.
+   boost::span<external_segment const> externals() const noexcept
+      { return externals_; }
+
+   /// Returns the number of bytes of external arguments.
+   std::size_t external_size() const noexcept
+   {
+      std::size_t ret = 0;
+      for (auto const& e: externals())
+         ret += e.arg.data.size();
+      return ret;
+   }
+
+   /// The lane of the request.
+   priority_lane lane = priority_lane::normal;
+
+   /// The tenant of the request.
+   std::size_t tenant = 0;
+
+   /// Whether the request is canceled when \c async_run completes.
+   bool close_on_run_completion = false;
+
+private:
+   void const* id_ = nullptr;
+   boost::string_view payload_;
+   boost::span<external_segment const> externals_;
+   std::size_t size_ = 0;
+};
+
 } // resp3
 } // aedis
 
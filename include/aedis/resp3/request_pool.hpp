@@ -0,0 +1,96 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_RESP3_REQUEST_POOL_HPP
+#define AEDIS_RESP3_REQUEST_POOL_HPP
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <aedis/resp3/request.hpp>
+
+namespace aedis {
+namespace resp3 {
+
+/** @brief A pool of reusable requests.
+ *  \ingroup any
+ *
+ *  Requests returned to the pool are cleared but keep their memory,
+ *  so that building requests of similar sizes doesn't allocate once
+ *  the pool is warm. For example
+ *
+ *  @code
+ *  auto req = this_thread_request_pool().acquire();
+ *  req->push("INCR", "key");
+ *  conn->async_exec(*req, adapt(resp), [req = std::move(req)](auto ec, auto n) { ... });
+ *  @endcode
+ *
+ *  The pool is not thread safe. A request released on a thread other
+ *  than the one that created the pool is deleted instead.
+ */
+class request_pool {
+public:
+   /// Returns requests to the pool.
+   class deleter {
+   public:
+      deleter() = default;
+
+      void operator()(request* req) const noexcept;
+
+   private:
+      friend request_pool;
+
+      explicit deleter(request_pool* pool) noexcept
+      : pool_{pool}, owner_{std::this_thread::get_id()}
+      { }
+
+      request_pool* pool_ = nullptr;
+      std::thread::id owner_;
+   };
+
+   /// A request owned by the pool.
+   using pointer = std::unique_ptr<request, deleter>;
+
+   /** \brief Constructor.
+    *
+    *  \param max_size Maximum number of idle requests kept.
+    *  \param max_capacity Requests with a larger capacity are deleted instead of kept.
+    */
+   explicit
+   request_pool(
+      std::size_t max_size = 64,
+      std::size_t max_capacity = 64 * 1024);
+
+   request_pool(request_pool const&) = delete;
+   request_pool& operator=(request_pool const&) = delete;
+
+   /// Returns an empty request, allocating only when the pool is empty.
+   pointer acquire();
+
+   /// Returns the number of idle requests.
+   std::size_t size() const noexcept { return free_.size(); }
+
+private:
+   void release(request* req) noexcept;
+
+   std::size_t max_size_;
+   std::size_t max_capacity_;
+   std::vector<std::unique_ptr<request>> free_;
+};
+
+/** @brief Returns the request pool of the calling thread.
+ *  \ingroup any
+ *
+ *  Requests acquired from it must be released before the thread
+ *  exits.
+ */
+request_pool& this_thread_request_pool();
+
+} // resp3
+} // aedis
+
+#endif // AEDIS_RESP3_REQUEST_POOL_HPP
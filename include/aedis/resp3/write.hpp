@@ -8,9 +8,27 @@
 #define AEDIS_RESP3_WRITE_HPP
 
 #include <boost/asio/write.hpp>
+#include <boost/container/small_vector.hpp>
 
 namespace aedis {
 namespace resp3 {
+namespace detail {
+
+// The payload interleaved with the external arguments of the request,
+// requests with at most one external argument don't allocate. The
+// type is the same with and without external arguments so that
+// async_write has a single return type.
+using request_buffers = boost::container::small_vector<boost::asio::const_buffer, 3>;
+
+template <class Request>
+request_buffers make_buffers(Request const& req)
+{
+   request_buffers ret;
+   req.for_each_buffer([&](auto const& buffer) { ret.push_back(buffer); });
+   return ret;
+}
+
+} // detail
 
 template<
    class SyncWriteStream,
@@ -18,7 +36,7 @@ template<
    >
 std::size_t write(SyncWriteStream& stream, Request const& req)
 {
-   return boost::asio::write(stream, boost::asio::buffer(req.payload()));
+   return boost::asio::write(stream, detail::make_buffers(req));
 }
 
 template<
@@ -30,7 +48,7 @@ std::size_t write(
     Request const& req,
     boost::system::error_code& ec)
 {
-   return boost::asio::write(stream, boost::asio::buffer(req.payload()), ec);
+   return boost::asio::write(stream, detail::make_buffers(req), ec);
 }
 
 template<
@@ -44,7 +62,7 @@ auto async_write(
    CompletionToken&& token =
       boost::asio::default_completion_token_t<typename AsyncWriteStream::executor_type>{})
 {
-   return boost::asio::async_write(stream, boost::asio::buffer(req.payload()), token);
+   return boost::asio::async_write(stream, detail::make_buffers(req), std::forward<CompletionToken>(token));
 }
 
 } // resp3
@@ -4,7 +4,19 @@
  * accompanying file LICENSE.txt)
  */
 
+#include <aedis/impl/coalescing_policy.ipp>
+#include <aedis/impl/diagnostics.ipp>
 #include <aedis/impl/error.ipp>
+#include <aedis/impl/hash_slot.ipp>
+#include <aedis/impl/latency_histogram.ipp>
+#include <aedis/impl/reconnect_policy.ipp>
+#include <aedis/impl/recording_stream.ipp>
+#include <aedis/impl/resolve_cache.ipp>
+#include <aedis/impl/stats.ipp>
+#include <aedis/impl/sync_connection.ipp>
+#include <aedis/impl/timer_wheel.ipp>
+#include <aedis/resp3/impl/prepared_command.ipp>
 #include <aedis/resp3/impl/request.ipp>
+#include <aedis/resp3/impl/request_pool.ipp>
 #include <aedis/resp3/impl/type.ipp>
 #include <aedis/resp3/detail/impl/parser.ipp>
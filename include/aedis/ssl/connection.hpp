@@ -0,0 +1,147 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_SSL_CONNECTION_HPP
+#define AEDIS_SSL_CONNECTION_HPP
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/ssl.hpp>
+
+#include <aedis/connection.hpp>
+
+namespace aedis {
+namespace detail {
+
+/* Next layer of TLS connections.
+ *
+ * Sets SNI before the handshake and keeps the session of the last
+ * connection, reconnections offer it to the server so that they cost
+ * an abbreviated handshake instead of a full one.
+ */
+template <class Stream>
+struct layer<boost::asio::ssl::stream<Stream>> {
+public:
+   using stream_type = boost::asio::ssl::stream<Stream>;
+
+   static constexpr bool requires_handshake = true;
+
+   explicit layer(boost::asio::ssl::context& ctx) noexcept
+   : ctx_{&ctx}
+   { }
+
+   layer(layer&& other) noexcept
+   : ctx_{other.ctx_}
+   , session_{std::exchange(other.session_, nullptr)}
+   { }
+
+   layer(layer const&) = delete;
+   layer& operator=(layer const&) = delete;
+   layer& operator=(layer&&) = delete;
+
+   ~layer()
+   {
+      if (session_ != nullptr)
+         SSL_SESSION_free(session_);
+   }
+
+   template <class Executor>
+   std::shared_ptr<stream_type> make_stream(Executor ex) const
+      { return std::make_shared<stream_type>(ex, *ctx_); }
+
+   template <class CompletionToken>
+   auto async_handshake(stream_type& stream, std::string const& host, CompletionToken&& token)
+   {
+      auto* ssl = stream.native_handle();
+
+      // SNI and host name verification don't apply to IP addresses.
+      boost::system::error_code ec;
+      boost::asio::ip::make_address(host, ec);
+      if (ec) {
+         SSL_set_tlsext_host_name(ssl, host.c_str());
+         SSL_set1_host(ssl, host.c_str());
+      }
+
+      if (session_ != nullptr)
+         SSL_set_session(ssl, session_);
+
+      return stream.async_handshake(
+         boost::asio::ssl::stream_base::client,
+         std::forward<CompletionToken>(token));
+   }
+
+   void on_close(stream_type& stream) noexcept
+   {
+      auto* ssl = stream.native_handle();
+      if (!SSL_is_init_finished(ssl))
+         return;
+
+      // The socket is closed without sending close_notify, which
+      // would otherwise cause OpenSSL to mark the session as not
+      // resumable.
+      SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+
+      // With TLS 1.3 the session ticket arrives after the handshake,
+      // that is why the session is fetched on close and not right
+      // after the handshake.
+      auto* session = SSL_get1_session(ssl);
+      if (session == nullptr)
+         return;
+
+      if (!SSL_SESSION_is_resumable(session)) {
+         SSL_SESSION_free(session);
+         return;
+      }
+
+      if (session_ != nullptr)
+         SSL_SESSION_free(session_);
+
+      session_ = session;
+   }
+
+private:
+   boost::asio::ssl::context* ctx_;
+   SSL_SESSION* session_ = nullptr;
+};
+
+} // detail
+
+namespace ssl {
+
+/** @brief A Redis connection over TLS.
+ *  @ingroup any
+ *
+ *  Constructed from a \c boost::asio::ssl::context, that must outlive
+ *  the connection, for example
+ *
+ *  @code
+ *  net::ssl::context ctx{net::ssl::context::tls_client};
+ *  aedis::ssl::connection<> db{ioc, ctx};
+ *  @endcode
+ *
+ *  The TLS handshake is performed by \c async_run right after
+ *  connecting and is subject to connection::config::connect_timeout.
+ *  The session of the previous connection is offered to the server on
+ *  reconnection so that it can be resumed, whether that succeeded can
+ *  be checked with
+ *
+ *  @code
+ *  SSL_session_reused(db.next_layer().native_handle());
+ *  @endcode
+ *
+ *  Resumption requires session tickets or a session cache to be
+ *  enabled on the server, which is the default for Redis.
+ */
+template <class AsyncReadWriteStream = boost::asio::ip::tcp::socket>
+using connection = aedis::connection<boost::asio::ssl::stream<AsyncReadWriteStream>>;
+
+} // ssl
+} // aedis
+
+#endif // AEDIS_SSL_CONNECTION_HPP
@@ -0,0 +1,149 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_STATS_HPP
+#define AEDIS_STATS_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace aedis {
+
+/** \brief A snapshot of the counters of a connection.
+ *  \ingroup any
+ *
+ *  See connection::stats.
+ */
+struct connection_stats {
+   /// Number of requests passed to \c async_exec.
+   std::uint64_t requests_queued = 0;
+
+   /// Number of requests that have not completed yet.
+   std::uint64_t requests_in_flight = 0;
+
+   /// Number of requests completed successfully.
+   std::uint64_t requests_completed = 0;
+
+   /// Number of requests completed with an error.
+   std::uint64_t requests_failed = 0;
+
+   /// Number of bytes of the responses and pushes read.
+   std::uint64_t bytes_read = 0;
+
+   /// Number of bytes written.
+   std::uint64_t bytes_written = 0;
+
+   /// Number of server pushes received.
+   std::uint64_t pushes_received = 0;
+
+   /// Number of reconnections.
+   std::uint64_t reconnects = 0;
+
+   /// Number of writes, each carrying a batch of coalesced requests.
+   std::uint64_t batches_written = 0;
+
+   /// Sum of the sizes of all batches.
+   std::uint64_t batched_requests = 0;
+
+   /// Size of the largest batch.
+   std::uint64_t max_batch_size = 0;
+
+   /// Largest capacity of the read buffer.
+   std::uint64_t read_buffer_high_water = 0;
+};
+
+/** \brief Renders statistics in the Prometheus text exposition format.
+ *  \ingroup any
+ *
+ *  Every metric is written once with one sample per connection,
+ *  distinguished by the \c connection label e.g.
+ *
+ *  @code
+ *  std::vector<std::pair<std::string, connection_stats>> v;
+ *  v.emplace_back("cache", db1->stats());
+ *  v.emplace_back("sessions", db2->stats());
+ *  std::cout << to_prometheus(v);
+ *  @endcode
+ *
+ *  The stats of connection pools can be rendered by labeling each
+ *  connection of the pool or by summing them into a single snapshot.
+ *
+ *  \param stats Pairs of label values and snapshots.
+ *  \param prefix The prefix of the metric names.
+ */
+std::string
+to_prometheus(
+   std::vector<std::pair<std::string, connection_stats>> const& stats,
+   std::string const& prefix = "aedis");
+
+namespace detail {
+
+// The counters are written only from the executor of the connection,
+// a relaxed load and store is enough and avoids locked instructions
+// on the hot path. stats() may be called from other threads.
+class stats_counters {
+public:
+   using counter_type = std::atomic<std::uint64_t>;
+
+   static void add(counter_type& c, std::uint64_t n = 1) noexcept
+      { c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+   static void update_max(counter_type& c, std::uint64_t n) noexcept
+   {
+      if (n > c.load(std::memory_order_relaxed))
+         c.store(n, std::memory_order_relaxed);
+   }
+
+   void on_batch(std::size_t size) noexcept
+   {
+      add(batches_written);
+      add(batched_requests, size);
+      update_max(max_batch_size, size);
+   }
+
+   connection_stats snapshot() const noexcept
+   {
+      auto const get = [](counter_type const& c)
+         { return c.load(std::memory_order_relaxed); };
+
+      connection_stats ret;
+      ret.requests_completed = get(requests_completed);
+      ret.requests_failed = get(requests_failed);
+      ret.requests_queued = get(requests_queued);
+      auto const done = ret.requests_completed + ret.requests_failed;
+      ret.requests_in_flight = ret.requests_queued > done ? ret.requests_queued - done : 0;
+      ret.bytes_read = get(bytes_read);
+      ret.bytes_written = get(bytes_written);
+      ret.pushes_received = get(pushes_received);
+      ret.reconnects = get(reconnects);
+      ret.batches_written = get(batches_written);
+      ret.batched_requests = get(batched_requests);
+      ret.max_batch_size = get(max_batch_size);
+      ret.read_buffer_high_water = get(read_buffer_high_water);
+      return ret;
+   }
+
+   counter_type requests_queued{0};
+   counter_type requests_completed{0};
+   counter_type requests_failed{0};
+   counter_type bytes_read{0};
+   counter_type bytes_written{0};
+   counter_type pushes_received{0};
+   counter_type reconnects{0};
+   counter_type batches_written{0};
+   counter_type batched_requests{0};
+   counter_type max_batch_size{0};
+   counter_type read_buffer_high_water{0};
+};
+
+} // detail
+} // aedis
+
+#endif // AEDIS_STATS_HPP
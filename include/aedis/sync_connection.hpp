@@ -0,0 +1,275 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_SYNC_CONNECTION_HPP
+#define AEDIS_SYNC_CONNECTION_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstddef>
+#include <iterator>
+#include <system_error>
+
+#include <boost/assert.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+
+#include <aedis/adapt.hpp>
+#include <aedis/exec_result.hpp>
+#include <aedis/reconnect_policy.hpp>
+#include <aedis/resp3/read.hpp>
+#include <aedis/resp3/request.hpp>
+#include <aedis/resp3/type.hpp>
+#include <aedis/resp3/write.hpp>
+
+namespace aedis {
+
+/** \brief A blocking Redis connection.
+ *  \ingroup any
+ *
+ *  Meant for command line tools and batch jobs that don't need
+ *  asynchronous operations. It owns the socket, every call blocks the
+ *  calling thread and no other thread is used, there is no need to
+ *  run an \c io_context. Requests are pipelined, all commands of a
+ *  request, or of all requests passed to \c exec_batch, are written
+ *  with a single write before their responses are read. For example
+ *
+ *  @code
+ *  aedis::sync_connection conn;
+ *
+ *  request req;
+ *  req.push("INCR", "key");
+ *  req.push("GET", "key");
+ *
+ *  std::tuple<int, std::string> resp;
+ *  conn.exec(req, adapt(resp));
+ *  @endcode
+ *
+ *  The connection is established on the first call to \c exec and
+ *  again after errors or when the server closed it since the last
+ *  call, e.g. after a timeout or a restart. Requests are written
+ *  again only when writing them failed on such a connection, i.e.
+ *  when they can't have been executed. Error responses to \c AUTH, \c
+ *  HELLO and config::init fail the connection. Server pushes received
+ *  while reading responses are ignored. This class is not thread
+ *  safe.
+ */
+class sync_connection {
+public:
+   /// Configuration parameters.
+   struct config {
+      /// Redis server address.
+      std::string host = "127.0.0.1";
+
+      /// Redis server port.
+      std::string port = "6379";
+
+      /// Username if authentication is required.
+      std::string username;
+
+      /// Password if authentication is required.
+      std::string password;
+
+      /// Commands sent after \c HELLO on every connection, their responses are ignored.
+      resp3::request init;
+
+      /// The maximum size allowed on read operations.
+      std::size_t max_read_size = (std::numeric_limits<std::size_t>::max)();
+
+      /// Whether to connect again when the connection was lost.
+      bool enable_reconnect = true;
+
+      /// Number of attempts when connecting, see reconnect_policy.
+      std::size_t connect_attempts = 3;
+
+      /// Minimum time waited between connection attempts.
+      std::chrono::milliseconds reconnect_interval = std::chrono::milliseconds{100};
+
+      /// Maximum time waited between connection attempts.
+      std::chrono::milliseconds max_reconnect_interval = std::chrono::seconds{2};
+   };
+
+   /// Constructor with the default configuration.
+   sync_connection();
+
+   /// Constructor.
+   explicit sync_connection(config cfg);
+
+   /// Returns the configuration.
+   config& get_config() noexcept { return cfg_; }
+
+   /// Returns the configuration.
+   config const& get_config() const noexcept { return cfg_; }
+
+   /// Whether the connection is established.
+   bool is_open() const noexcept { return socket_.is_open(); }
+
+   /** \brief Connects, authenticates and sends \c HELLO.
+    *
+    *  Called automatically by \c exec. Retries up to
+    *  config::connect_attempts times with backoff.
+    */
+   void connect(boost::system::error_code& ec);
+
+   /// Closes the connection.
+   void close();
+
+   /** \brief Executes a request, blocking until all responses are read.
+    *
+    *  \param req The request, of any allocator.
+    *  \param adapter The response adapter, as in connection::async_exec.
+    *  \param ec Error code in case of error.
+    *  \returns The size of the responses in bytes.
+    */
+   template <class Allocator, class Adapter>
+   std::size_t
+   exec(
+      resp3::basic_request<Allocator> const& req,
+      Adapter adapter,
+      boost::system::error_code& ec)
+   {
+      BOOST_ASSERT_MSG(req.size() <= adapter.supported_response_size(), "Request and adapter have incompatible sizes.");
+
+      buffers_.clear();
+      req.for_each_buffer([this](auto const& buffer) { buffers_.push_back(buffer); });
+
+      write_buffers(ec);
+      if (ec)
+         return 0;
+
+      return read_responses(req.size(), adapter, ec);
+   }
+
+   /** \brief Executes a request, blocking until all responses are read.
+    *
+    *  \throws std::system_error in case of error.
+    */
+   template <
+      class Allocator,
+      class Adapter = detail::response_traits<void>::adapter_type>
+   std::size_t exec(resp3::basic_request<Allocator> const& req, Adapter adapter = adapt())
+   {
+      boost::system::error_code ec;
+      auto const n = exec(req, adapter, ec);
+      if (ec)
+         throw std::system_error(ec);
+      return n;
+   }
+
+   /** \brief Executes many requests with a single write.
+    *
+    *  The payloads are written with a gather write, without copies,
+    *  and the responses are read in order with the corresponding
+    *  adapters. The requests after the first one that fails fail with
+    *  the same error.
+    *
+    *  \param reqs Range of requests, of any allocator.
+    *  \param adapters Range of response adapters of the same size.
+    *  \param ec Error code of the first request that failed.
+    *  \returns The result of each request.
+    */
+   template <class Requests, class Adapters>
+   std::vector<exec_result>
+   exec_batch(
+      Requests const& reqs,
+      Adapters const& adapters,
+      boost::system::error_code& ec)
+   {
+      BOOST_ASSERT_MSG(std::size(reqs) == std::size(adapters), "Requests and adapters have different sizes.");
+
+      ec = {};
+      std::vector<exec_result> ret(std::size(reqs));
+      if (ret.empty())
+         return ret;
+
+      buffers_.clear();
+      for (auto const& req: reqs)
+         req.for_each_buffer([this](auto const& buffer) { buffers_.push_back(buffer); });
+
+      write_buffers(ec);
+      if (ec) {
+         for (auto& r: ret)
+            r.error = ec;
+         return ret;
+      }
+
+      auto adapter = std::cbegin(adapters);
+      auto result = std::begin(ret);
+      for (auto const& req: reqs) {
+         if (!ec) {
+            auto a = *adapter;
+            result->size = read_responses(req.size(), a, ec);
+         }
+
+         result->error = ec;
+         ++adapter;
+         ++result;
+      }
+
+      return ret;
+   }
+
+private:
+   // Whether the server did not close the connection.
+   bool is_alive();
+
+   // Connects if needed and writes buffers_, closes on errors.
+   void write_buffers(boost::system::error_code& ec);
+
+   template <class Adapter>
+   std::size_t read_responses(std::size_t cmds, Adapter& adapter, boost::system::error_code& ec)
+   {
+      std::size_t size = 0;
+      for (std::size_t i = 0; i < cmds;) {
+         if (buffer_.empty()) {
+            boost::asio::read_until(socket_, make_dynamic_buffer(), "\r\n", ec);
+            if (ec)
+               break;
+         }
+
+         if (resp3::to_type(buffer_.front()) == resp3::type::push) {
+            size += resp3::read(socket_, make_dynamic_buffer(), aedis::adapter::adapt(), ec);
+            if (ec)
+               break;
+
+            continue;
+         }
+
+         size += resp3::read(socket_, make_dynamic_buffer(),
+            [i, &adapter](resp3::node<boost::string_view> const& nd, boost::system::error_code& ec) { adapter(i, nd, ec); },
+            ec);
+
+         if (ec)
+            break;
+
+         ++i;
+      }
+
+      // The stream is not in a known state after an error.
+      if (ec)
+         close();
+
+      return size;
+   }
+
+   auto make_dynamic_buffer()
+      { return boost::asio::dynamic_buffer(buffer_, cfg_.max_read_size); }
+
+   config cfg_;
+   boost::asio::io_context ioc_{1};
+   boost::asio::ip::tcp::socket socket_;
+   std::string buffer_;
+   std::vector<boost::asio::const_buffer> buffers_;
+   bool connected_once_ = false;
+};
+
+} // aedis
+
+#endif // AEDIS_SYNC_CONNECTION_HPP
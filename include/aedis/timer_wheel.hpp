@@ -0,0 +1,142 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_TIMER_WHEEL_HPP
+#define AEDIS_TIMER_WHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/any_io_executor.hpp>
+
+namespace aedis {
+
+/** \brief A hierarchical timer wheel shared by many connections.
+ *  \ingroup any
+ *
+ *  Arms and cancels timers in constant time at the cost of a coarse
+ *  granularity. A single \c steady_timer drives the wheel, so a
+ *  large number of connections does not translate into a large
+ *  number of entries in the timer queue of the \c io_context.
+ *
+ *  The first level has 256 slots of one tick each and the second 64
+ *  slots of 256 ticks each. With the default granularity of 100ms
+ *  timers up to 25.6s are placed directly in the first level and up
+ *  to about 27 minutes in the second. Longer timers are cascaded
+ *  until they fit.
+ *
+ *  The wheel must be created with \c std::make_shared and is not
+ *  thread safe: it and all entries must be used from the same
+ *  (implicit or explicit) strand. To use it for the health checks of
+ *  connections set connection::config::wheel.
+ */
+class timer_wheel : public std::enable_shared_from_this<timer_wheel> {
+public:
+   using clock_type = std::chrono::steady_clock;
+   using duration = std::chrono::milliseconds;
+
+   /** \brief A timer in the wheel.
+    *
+    *  Calls the callback with the user data when it expires, the
+    *  entry is not armed anymore at that point and can be armed
+    *  again from the callback. Destroying an armed entry cancels it.
+    */
+   class entry {
+   public:
+      using callback_type = void(*)(void*);
+
+      /// Constructor.
+      entry(callback_type cb, void* data) noexcept
+      : cb_{cb}, data_{data}
+      { }
+
+      entry(entry const&) = delete;
+      entry& operator=(entry const&) = delete;
+
+      /// Destructor.
+      ~entry() { cancel(); }
+
+      /// Whether the entry is armed.
+      bool armed() const noexcept { return wheel_ != nullptr; }
+
+      /// Cancels the entry without calling the callback.
+      void cancel() noexcept;
+
+   private:
+      friend class timer_wheel;
+
+      callback_type cb_;
+      void* data_;
+      timer_wheel* wheel_ = nullptr;
+      entry** slot_ = nullptr;
+      entry* prev_ = nullptr;
+      entry* next_ = nullptr;
+      std::uint64_t expiry_ = 0;
+   };
+
+   /** \brief Constructor.
+    *
+    *  \param ex The executor the wheel runs on.
+    *  \param granularity The duration of a tick.
+    */
+   explicit
+   timer_wheel(
+      boost::asio::any_io_executor ex,
+      duration granularity = std::chrono::milliseconds{100});
+
+   timer_wheel(timer_wheel const&) = delete;
+   timer_wheel& operator=(timer_wheel const&) = delete;
+
+   /// Destructor, cancels all entries.
+   ~timer_wheel();
+
+   /** \brief Arms an entry.
+    *
+    *  Rearms the entry if it is already armed. The expiry is rounded
+    *  up to the next tick.
+    *
+    *  \param e The entry.
+    *  \param after Time from now until expiry.
+    */
+   void arm(entry& e, duration after);
+
+   /// Returns the number of armed entries.
+   std::size_t size() const noexcept { return size_; }
+
+   /// Returns the granularity.
+   duration granularity() const noexcept { return granularity_; }
+
+   /// Returns the executor.
+   auto get_executor() { return timer_.get_executor(); }
+
+private:
+   static constexpr std::size_t level0_slots = 256;
+   static constexpr std::size_t level1_slots = 64;
+
+   std::uint64_t current_tick() const;
+   void link(entry& e);
+   void unlink(entry& e) noexcept;
+   void process(std::uint64_t tick);
+   void start();
+   void on_timer();
+
+   std::array<entry*, level0_slots> level0_{};
+   std::array<entry*, level1_slots> level1_{};
+   duration granularity_;
+   clock_type::time_point start_;
+   std::uint64_t now_ = 0;
+   std::size_t size_ = 0;
+   bool running_ = false;
+   boost::asio::steady_timer timer_;
+};
+
+} // aedis
+
+#endif // AEDIS_TIMER_WHEEL_HPP
@@ -0,0 +1,78 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#ifndef AEDIS_TRACER_HPP
+#define AEDIS_TRACER_HPP
+
+#include <chrono>
+#include <cstddef>
+
+#include <boost/system/error_code.hpp>
+
+#include <aedis/resp3/request.hpp>
+
+namespace aedis {
+
+/** \brief The default tracer of the connection, does nothing.
+ *  \ingroup any
+ *
+ *  A tracer is passed as the second template parameter of
+ *  connection and is notified at the points documented below, e.g. to
+ *  correlate the time spent in Redis with the spans of the
+ *  application, see tracing.cpp. User tracers must provide all of
+ *  these functions, which are called from the executor of the
+ *  connection and must not throw. The tracer is default constructed
+ *  by the connection and can be accessed with
+ *  connection::get_tracer. Requests are passed as a
+ *  resp3::request_view, whose \c id identifies the request across
+ *  the calls.
+ *
+ *  As the functions are empty and the class has no state, this
+ *  tracer takes no space in the connection and adds no code.
+ */
+struct no_tracer {
+   /// A request was passed to \c async_exec.
+   void on_exec(resp3::request_view const&) noexcept {}
+
+   /** \brief A request is about to be written.
+    *
+    *  Called for every request of a batch of coalesced requests, the
+    *  second parameter is the size of its payload.
+    */
+   void on_write_begin(resp3::request_view const&, std::size_t) noexcept {}
+
+   /// A batch of requests was written, with the number of bytes written.
+   void on_write_end(boost::system::error_code, std::size_t) noexcept {}
+
+   /// The first response to a request is about to be read.
+   void on_response_begin(resp3::request_view const&) noexcept {}
+
+   /** \brief The \c async_exec of a request completes.
+    *
+    *  Called once for every call to \c on_exec, also when the request
+    *  fails without being written, with the number of bytes read.
+    */
+   void on_response_end(resp3::request_view const&, boost::system::error_code, std::size_t) noexcept {}
+
+   /// The resolve operation completed.
+   void on_resolve(boost::system::error_code) noexcept {}
+
+   /// The connect operation completed.
+   void on_connect(boost::system::error_code) noexcept {}
+
+   /// The handshake of the next layer (e.g. TLS) completed.
+   void on_handshake(boost::system::error_code) noexcept {}
+
+   /// The responses to \c HELLO and connection::config::init were received.
+   void on_hello(boost::system::error_code) noexcept {}
+
+   /// A reconnection will be attempted after the delay.
+   void on_reconnect(std::size_t, std::chrono::milliseconds) noexcept {}
+};
+
+} // aedis
+
+#endif // AEDIS_TRACER_HPP
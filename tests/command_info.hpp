@@ -0,0 +1,110 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <aedis/resp3/command.hpp>
+#include <aedis/resp3/node.hpp>
+#include <aedis/resp3/type.hpp>
+
+// The commands of the table that COMMAND INFO is asked about. SENTINEL
+// is only known in sentinel mode.
+inline std::vector<aedis::resp3::command_info const*> command_info_commands()
+{
+   std::vector<aedis::resp3::command_info const*> ret;
+   for (auto const& cmd: aedis::resp3::detail::command_infos) {
+      if (cmd.id != aedis::resp3::command::sentinel)
+         ret.push_back(&cmd);
+   }
+
+   return ret;
+}
+
+struct command_info_diff {
+   // Commands whose arity, key positions or kind differ.
+   std::vector<std::string> mismatches;
+   // Commands unknown to the server, their entry is null.
+   std::vector<std::string> unknown;
+};
+
+/* Compares the command table with the reply to COMMAND INFO for
+ * command_info_commands(), an entry
+ *
+ *    [name, arity, flags, first key, last key, key step, ...]
+ *
+ * per command. Whether the response is a push is not in COMMAND INFO,
+ * so subscribe is compared as pubsub. The kind is taken from the
+ * flags: pubsub, then write, then readonly, otherwise other.
+ */
+inline command_info_diff
+compare_command_info(std::vector<aedis::resp3::node<std::string>> const& reply)
+{
+   using aedis::resp3::command_kind;
+   using node_type = aedis::resp3::node<std::string>;
+
+   std::vector<std::vector<node_type>> entries;
+   for (auto const& n: reply) {
+      if (n.depth == 1)
+         entries.emplace_back();
+      if (n.depth >= 1)
+         entries.back().push_back(n);
+   }
+
+   auto const cmds = command_info_commands();
+   command_info_diff ret;
+   for (std::size_t i = 0; i < cmds.size(); ++i) {
+      auto const& cmd = *cmds[i];
+      std::string const name{cmd.name.data(), cmd.name.size()};
+      if (i >= entries.size()) {
+         ret.mismatches.push_back(name);
+         continue;
+      }
+
+      auto const& e = entries[i];
+      if (e.front().data_type == aedis::resp3::type::null) {
+         ret.unknown.push_back(name);
+         continue;
+      }
+
+      std::vector<std::size_t> fields;
+      for (std::size_t j = 1; j < e.size(); ++j) {
+         if (e[j].depth == 2)
+            fields.push_back(j);
+      }
+
+      if (fields.size() < 6) {
+         ret.mismatches.push_back(name);
+         continue;
+      }
+
+      std::vector<std::string> flags;
+      for (std::size_t j = fields[2] + 1; j < fields[3]; ++j)
+         flags.push_back(e[j].value);
+
+      auto const has = [&](char const* flag)
+         { return std::find(std::begin(flags), std::end(flags), flag) != std::end(flags); };
+
+      auto const kind =
+         has("pubsub") ? command_kind::pubsub :
+         has("write") ? command_kind::write :
+         has("readonly") ? command_kind::readonly :
+         command_kind::other;
+
+      auto const same =
+         aedis::resp3::find_command(e[fields[0]].value) == &cmd &&
+         std::stoi(e[fields[1]].value) == cmd.arity &&
+         std::stoi(e[fields[3]].value) == cmd.first_key &&
+         std::stoi(e[fields[4]].value) == cmd.last_key &&
+         std::stoi(e[fields[5]].value) == cmd.key_step &&
+         (cmd.kind == command_kind::subscribe ? command_kind::pubsub : cmd.kind) == kind;
+
+      if (!same)
+         ret.mismatches.push_back(name);
+   }
+
+   return ret;
+}
@@ -9,15 +9,27 @@
 // TODO: Add reconnect test that kills the server and waits some
 // seconds.
 
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <memory_resource>
+#include <thread>
 #include <iostream>
 #include <boost/asio.hpp>
 #include <boost/system/errc.hpp>
 #include <boost/asio/experimental/as_tuple.hpp>
 
 #include <aedis.hpp>
+#include <aedis/experimental/hub.hpp>
+#include <aedis/experimental/sync.hpp>
 #include <aedis/src.hpp>
 
 #include "check.hpp"
+#include "command_info.hpp"
+#include "server.hpp"
 
 namespace net = boost::asio;
 
@@ -71,6 +83,40 @@ void test_connect()
 
 //----------------------------------------------------------------
 
+// A failed connect doesn't remove the cached addresses, they are used
+// when the host can't be resolved on the next attempt.
+void test_resolve_cache_fallback()
+{
+   auto cache = std::make_shared<aedis::resolve_cache>(std::chrono::seconds{30});
+   cache->insert("aedis.invalid", "6379", {{net::ip::make_address("127.0.0.1"), 1}});
+
+   connection::config cfg;
+   cfg.host = "aedis.invalid";
+   cfg.port = "6379";
+   cfg.resolve_cache = cache;
+
+   net::io_context ioc;
+   connection db1{ioc, cfg};
+   db1.async_run([](auto ec) {
+      expect_error(ec, net::error::basic_errors::connection_refused, "test_resolve_cache_fallback.connect");
+   });
+   ioc.run();
+
+   aedis::resolve_cache::endpoints_type eps;
+   expect_eq(cache->find(cfg.host, cfg.port, eps), false, "test_resolve_cache_fallback.stale");
+   expect_eq(cache->find(cfg.host, cfg.port, eps, true), true, "test_resolve_cache_fallback.kept");
+
+   // The resolver fails and the stale addresses are connected to.
+   ioc.restart();
+   connection db2{ioc, cfg};
+   db2.async_run([](auto ec) {
+      expect_error(ec, net::error::basic_errors::connection_refused, "test_resolve_cache_fallback.resolve");
+   });
+   ioc.run();
+}
+
+//----------------------------------------------------------------
+
 // Test if quit causes async_run to exit.
 void test_quit1(connection::config const& cfg)
 {
@@ -91,6 +137,336 @@ void test_quit1(connection::config const& cfg)
    ioc.run();
 }
 
+void test_init()
+{
+   connection::config cfg;
+   cfg.init.push("CLIENT", "SETNAME", "aedis-init");
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc, cfg);
+
+   request req;
+   req.push("CLIENT", "GETNAME");
+   req.push("QUIT");
+
+   std::tuple<std::string, aedis::ignore> resp;
+   db->async_run(req, aedis::adapt(resp), [&](auto ec, auto){
+      expect_no_error(ec, "test_init");
+      expect_eq(std::get<0>(resp), std::string{"aedis-init"}, "test_init");
+   });
+
+   ioc.run();
+}
+
+// An error response to the init commands fails the connection.
+void test_init_error()
+{
+   connection::config cfg;
+   cfg.init.push("CLIENT", "SETNAME", "aedis-init");
+   cfg.init.push("SELECT", 100000);
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc, cfg);
+   db->async_run([](auto ec) {
+      expect_error(ec, aedis::error::simple_error, "test_init_error");
+   });
+
+   ioc.run();
+}
+
+void test_submitter()
+{
+   net::io_context ioc;
+   connection db{ioc};
+
+   std::thread runner{[&]() {
+      db.async_run([](auto ec) {
+         expect_error(ec, net::error::misc_errors::eof, "test_submitter");
+      });
+      ioc.run();
+   }};
+
+   aedis::experimental::submitter<connection> sub{db};
+
+   request req;
+   req.push("PING");
+
+   std::vector<std::thread> threads;
+   for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&]() {
+         for (int j = 0; j < 100; ++j) {
+            std::tuple<std::string> resp;
+            sub.exec(req, aedis::adapt(resp));
+            expect_eq(std::get<0>(resp), std::string{"PONG"});
+         }
+      });
+   }
+
+   for (auto& t: threads)
+      t.join();
+
+   request quit;
+   quit.push("QUIT");
+   sub.exec(quit);
+   runner.join();
+}
+
+void test_exec_batch()
+{
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+
+   std::vector<request> reqs(3);
+   reqs[0].push("PING", "a");
+   reqs[1].push("PING", "b");
+   reqs[2].push("QUIT");
+
+   std::vector<std::tuple<std::string>> resps(3);
+   std::vector<decltype(aedis::adapt(resps[0]))> adapters;
+   for (auto& resp: resps)
+      adapters.push_back(aedis::adapt(resp));
+
+   db->async_exec_batch(reqs, adapters, [&](auto ec, std::vector<aedis::exec_result> res) {
+      expect_no_error(ec, "test_exec_batch");
+      expect_eq(res.size(), std::size_t{3}, "test_exec_batch.size");
+      expect_eq(std::get<0>(resps[0]), std::string{"a"}, "test_exec_batch.a");
+      expect_eq(std::get<0>(resps[1]), std::string{"b"}, "test_exec_batch.b");
+      expect_eq(std::get<0>(resps[2]), std::string{"OK"}, "test_exec_batch.quit");
+   });
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_exec_batch.run");
+   });
+
+   ioc.run();
+}
+
+// A failed request fails the requests after it with its error.
+void test_exec_batch_error()
+{
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+
+   std::vector<request> reqs(3);
+   reqs[0].push("SET", "aedis-batch-error", "a");
+   reqs[1].push("INCR", "aedis-batch-error");
+   reqs[2].push("PING", "c");
+
+   std::vector<std::tuple<std::string>> resps(3);
+   std::vector<decltype(aedis::adapt(resps[0]))> adapters;
+   for (auto& resp: resps)
+      adapters.push_back(aedis::adapt(resp));
+
+   db->async_exec_batch(reqs, adapters, [&](auto ec, std::vector<aedis::exec_result> res) {
+      expect_error(ec, aedis::error::simple_error, "test_exec_batch_error");
+      expect_eq(res.size(), std::size_t{3}, "test_exec_batch_error.size");
+      expect_no_error(res[0].error, "test_exec_batch_error.first");
+      expect_true(res[0].size != 0, "test_exec_batch_error.first_size");
+      expect_error(res[1].error, aedis::error::simple_error, "test_exec_batch_error.failed");
+      expect_error(res[2].error, aedis::error::simple_error, "test_exec_batch_error.last");
+      expect_eq(res[2].size, std::size_t{0}, "test_exec_batch_error.last_size");
+      expect_eq(std::get<0>(resps[0]), std::string{"OK"}, "test_exec_batch_error.set");
+      expect_true(std::get<0>(resps[2]).empty(), "test_exec_batch_error.unread");
+   });
+
+   db->async_run([](auto) { });
+
+   ioc.run();
+}
+
+void test_sync_connection()
+{
+   std::cout << "test_sync_connection" << std::endl;
+   aedis::sync_connection conn;
+
+   request req;
+   req.push("PING", "a");
+   req.push("PING", "b");
+
+   std::tuple<std::string, std::string> resp;
+   boost::system::error_code ec;
+   conn.exec(req, aedis::adapt(resp), ec);
+   expect_no_error(ec, "test_sync_connection.exec");
+   expect_eq(std::get<0>(resp), std::string{"a"}, "test_sync_connection.a");
+   expect_eq(std::get<1>(resp), std::string{"b"}, "test_sync_connection.b");
+
+   std::vector<request> reqs(2);
+   reqs[0].push("PING", "c");
+   reqs[1].push("QUIT");
+
+   std::vector<std::tuple<std::string>> resps(2);
+   std::vector<decltype(aedis::adapt(resps[0]))> adapters;
+   for (auto& r: resps)
+      adapters.push_back(aedis::adapt(r));
+
+   auto const res = conn.exec_batch(reqs, adapters, ec);
+   expect_no_error(ec, "test_sync_connection.exec_batch");
+   expect_eq(res.size(), std::size_t{2}, "test_sync_connection.size");
+   expect_eq(std::get<0>(resps[0]), std::string{"c"}, "test_sync_connection.c");
+   expect_eq(std::get<0>(resps[1]), std::string{"OK"}, "test_sync_connection.quit");
+
+   // The server closed the connection after QUIT, which is only
+   // noticed when the next request is written.
+   std::this_thread::sleep_for(std::chrono::milliseconds{100});
+   expect_true(conn.is_open(), "test_sync_connection.open");
+
+   request req2;
+   req2.push("PING", "d");
+   std::tuple<std::string> resp2;
+   conn.exec(req2, aedis::adapt(resp2), ec);
+   expect_no_error(ec, "test_sync_connection.reconnect");
+   expect_eq(std::get<0>(resp2), std::string{"d"}, "test_sync_connection.d");
+
+   // Also after an explicit close.
+   conn.close();
+   expect_true(!conn.is_open(), "test_sync_connection.close");
+   conn.exec(req2, aedis::adapt(resp2), ec);
+   expect_no_error(ec, "test_sync_connection.close.reconnect");
+
+   // Error responses to the init commands fail the connection.
+   aedis::sync_connection::config cfg;
+   cfg.init.push("SELECT", 100000);
+   aedis::sync_connection bad{cfg};
+   bad.exec(req2, aedis::adapt(resp2), ec);
+   expect_error(ec, aedis::error::simple_error, "test_sync_connection.init");
+}
+
+void test_external_arg()
+{
+   std::cout << "test_external_arg" << std::endl;
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+
+   auto const value = std::make_shared<std::string>(1024 * 1024, 'v');
+
+   request req;
+   req.push("SET", "external-key", aedis::resp3::external(net::buffer(*value), value));
+   req.push("GET", "external-key");
+   req.push("QUIT");
+
+   std::tuple<std::string, std::string, std::string> resp;
+   db->async_exec(req, aedis::adapt(resp), [&](auto ec, auto) {
+      expect_no_error(ec, "test_external_arg");
+      expect_eq(std::get<0>(resp), std::string{"OK"}, "test_external_arg.set");
+      expect_true(std::get<1>(resp) == *value, "test_external_arg.get");
+   });
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_external_arg.run");
+   });
+
+   ioc.run();
+}
+
+void test_allocator_request()
+{
+   std::cout << "test_allocator_request" << std::endl;
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+
+   char buffer[512];
+   std::pmr::monotonic_buffer_resource resource{buffer, sizeof buffer};
+   aedis::resp3::basic_request<std::pmr::polymorphic_allocator<char>> req{&resource};
+   req.push("PING", "pmr");
+   req.push("QUIT");
+
+   std::tuple<std::string, std::string> resp;
+   db->async_exec(req, aedis::adapt(resp), [&](auto ec, auto) {
+      expect_no_error(ec, "test_allocator_request");
+      expect_eq(std::get<0>(resp), std::string{"pmr"}, "test_allocator_request.ping");
+   });
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_allocator_request.run");
+   });
+
+   ioc.run();
+
+   aedis::sync_connection conn;
+   std::get<0>(resp).clear();
+   conn.exec(req, aedis::adapt(resp));
+   expect_eq(std::get<0>(resp), std::string{"pmr"}, "test_allocator_request.sync");
+}
+
+// Compares the command table with the output of COMMAND INFO of the
+// server, see also test_command_info_capture in low_level.cpp.
+void test_command_info()
+{
+   std::cout << "test_command_info" << std::endl;
+
+   std::vector<std::string> names;
+   for (auto const* cmd: command_info_commands())
+      names.push_back(std::string{cmd->name});
+
+   request req;
+   req.push_range("COMMAND", "INFO", names);
+   req.push("QUIT");
+
+   std::tuple<std::vector<aedis::resp3::node<std::string>>, std::string> resp;
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+   db->async_exec(req, aedis::adapt(resp), [&](auto ec, auto) {
+      expect_no_error(ec, "test_command_info");
+
+      std::string diff;
+      auto const res = compare_command_info(std::get<0>(resp));
+      for (auto const& name: res.mismatches)
+         diff += " " + name;
+      for (auto const& name: res.unknown)
+         diff += " " + name + "(unknown)";
+
+      expect_true(diff.empty(), "test_command_info.table" + diff);
+   });
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_command_info.run");
+   });
+
+   ioc.run();
+}
+
+// Tests a connection over a Unix domain socket, see config::path.
+void test_unix_socket()
+{
+   std::cout << "test_unix_socket" << std::endl;
+   using local_connection = aedis::connection<net::local::stream_protocol::socket>;
+
+   std::string const path = "aedis_test_unix_socket.sock";
+   std::remove(path.c_str());
+
+   net::io_context sioc;
+   net::local::stream_protocol::acceptor acceptor{sioc, {path}};
+   std::thread server{[&]() {
+      auto socket = acceptor.accept();
+      serve_redis(socket);
+   }};
+
+   local_connection::config cfg;
+   cfg.path = path;
+
+   net::io_context ioc;
+   local_connection db{ioc, cfg};
+
+   request req;
+   req.push("PING", "unix");
+   req.push("QUIT");
+
+   std::tuple<std::string, std::string> resp;
+   db.async_exec(req, aedis::adapt(resp), [&](auto ec, auto) {
+      expect_no_error(ec, "test_unix_socket");
+      expect_eq(std::get<0>(resp), std::string{"unix"}, "test_unix_socket.ping");
+   });
+
+   db.async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_unix_socket.run");
+   });
+
+   ioc.run();
+   server.join();
+   std::remove(path.c_str());
+}
+
 void test_quit2(connection::config const& cfg)
 {
    std::cout << "test_quit2" << std::endl;
@@ -198,6 +574,259 @@ void test_idle()
    ioc.run();
 }
 
+// Sends a request every quarter of ping_interval for five intervals
+// and checks whether the health check sends no PING, as data is
+// received all the time.
+void test_health_check_busy()
+{
+   std::cout << "test_health_check_busy" << std::endl;
+   using namespace std::chrono_literals;
+
+   connection::config cfg;
+   cfg.ping_interval = 200ms;
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc, cfg);
+
+   request ping;
+   ping.push("PING");
+
+   request quit;
+   quit.push("QUIT");
+
+   std::size_t const n = 20;
+   std::size_t sent = 0;
+   net::steady_timer timer{ioc};
+   std::function<void()> send = [&]() {
+      db->async_exec(ping, aedis::adapt(), [&](auto ec, auto) {
+         expect_no_error(ec, "test_health_check_busy.exec");
+         if (++sent == n) {
+            db->async_exec(quit, aedis::adapt(), [](auto, auto) { });
+            return;
+         }
+
+         timer.expires_after(cfg.ping_interval / 4);
+         timer.async_wait([&](auto) { send(); });
+      });
+   };
+
+   send();
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_health_check_busy.run");
+   });
+
+   ioc.run();
+
+   // The requests above are the only ones.
+   expect_eq(db->stats().requests_queued, std::uint64_t{n + 1}, "test_health_check_busy");
+}
+
+// Checks whether the health check of an idle connection sends PINGs.
+void test_health_check_idle()
+{
+   std::cout << "test_health_check_idle" << std::endl;
+   using namespace std::chrono_literals;
+
+   connection::config cfg;
+   cfg.ping_interval = 200ms;
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc, cfg);
+
+   request quit;
+   quit.push("QUIT");
+
+   net::steady_timer timer{ioc, 5 * cfg.ping_interval};
+   timer.async_wait([&](auto) {
+      db->async_exec(quit, aedis::adapt(), [](auto, auto) { });
+   });
+
+   db->async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_health_check_idle.run");
+   });
+
+   ioc.run();
+
+   // At least one PING besides the QUIT.
+   expect_true(db->stats().requests_queued > 1, "test_health_check_idle");
+}
+
+// Records the calls to the tracer, requests are named by their first
+// command.
+struct recording_tracer {
+   std::vector<std::string> calls;
+
+   static std::string name(aedis::resp3::request_view const& req)
+   {
+      auto const payload = req.payload();
+      auto const begin = payload.find("\r\n", payload.find('$')) + 2;
+      return std::string{payload.substr(begin, payload.find("\r\n", begin) - begin)};
+   }
+
+   static std::string result(error_code ec)
+      { return ec ? ec.message() : "ok"; }
+
+   void on_exec(aedis::resp3::request_view const& req) noexcept
+      { calls.push_back("exec " + name(req)); }
+
+   void on_write_begin(aedis::resp3::request_view const& req, std::size_t n) noexcept
+      { calls.push_back("write_begin " + name(req) + " " + std::to_string(n)); }
+
+   void on_write_end(error_code ec, std::size_t n) noexcept
+      { calls.push_back("write_end " + result(ec) + " " + std::to_string(n)); }
+
+   void on_response_begin(aedis::resp3::request_view const& req) noexcept
+      { calls.push_back("response_begin " + name(req)); }
+
+   void on_response_end(aedis::resp3::request_view const& req, error_code ec, std::size_t n) noexcept
+      { calls.push_back("response_end " + name(req) + " " + result(ec) + " " + std::to_string(n)); }
+
+   void on_resolve(error_code ec) noexcept
+      { calls.push_back("resolve " + result(ec)); }
+
+   void on_connect(error_code ec) noexcept
+      { calls.push_back("connect " + result(ec)); }
+
+   void on_handshake(error_code ec) noexcept
+      { calls.push_back("handshake " + result(ec)); }
+
+   void on_hello(error_code ec) noexcept
+      { calls.push_back("hello " + result(ec)); }
+
+   void on_reconnect(std::size_t attempt, std::chrono::milliseconds) noexcept
+      { calls.push_back("reconnect " + std::to_string(attempt)); }
+};
+
+// Checks whether the connection calls the tracer in order and with
+// the sizes of what is written and read, over a reconnection.
+void test_tracer()
+{
+   std::cout << "test_tracer" << std::endl;
+   using traced_connection = aedis::connection<net::ip::tcp::socket, recording_tracer>;
+
+   traced_connection::config cfg;
+   cfg.enable_events = true;
+   cfg.enable_reconnect = true;
+   cfg.reconnect_interval = std::chrono::milliseconds{100};
+   cfg.ping_interval = std::chrono::seconds{10};
+
+   net::io_context ioc;
+   auto db = std::make_shared<traced_connection>(ioc, cfg);
+
+   request ping;
+   ping.push("PING");
+
+   request quit;
+   quit.push("QUIT");
+
+   // PING and QUIT once per connection, then the reconnection is
+   // disabled so that the second QUIT completes async_run.
+   int hellos = 0;
+   std::function<void()> receive = [&]() {
+      db->async_receive_event(aedis::adapt(), [&](auto ec, auto ev) {
+         if (ec)
+            return;
+
+         if (ev == traced_connection::event::hello) {
+            if (++hellos == 2)
+               db->get_config().enable_reconnect = false;
+
+            db->async_exec(ping, aedis::adapt(), [&](auto ec, auto) {
+               expect_no_error(ec, "test_tracer.ping");
+               db->async_exec(quit, aedis::adapt(), [&](auto ec, auto) {
+                  expect_no_error(ec, "test_tracer.quit");
+               });
+            });
+         }
+
+         receive();
+      });
+   };
+
+   receive();
+
+   db->async_run([&](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_tracer.run");
+      db->cancel_event_receiver();
+   });
+
+   ioc.run();
+
+   // The payloads of PING and QUIT are *1\r\n$4\r\nPING\r\n, 14 bytes,
+   // their responses +PONG\r\n and +OK\r\n.
+   std::vector<std::string> const session
+      { "resolve ok"
+      , "connect ok"
+      , "hello ok"
+      , "exec PING"
+      , "write_begin PING 14"
+      , "write_end ok 14"
+      , "response_begin PING"
+      , "response_end PING ok 7"
+      , "exec QUIT"
+      , "write_begin QUIT 14"
+      , "write_end ok 14"
+      , "response_begin QUIT"
+      , "response_end QUIT ok 5"
+      };
+
+   auto expected = session;
+   expected.push_back("reconnect 1");
+   expected.insert(std::end(expected), std::cbegin(session), std::cend(session));
+
+   auto const& calls = db->get_tracer().calls;
+   expect_eq(calls, expected, "test_tracer.calls");
+}
+
+// Checks whether all listeners of a channel receive the same message
+// over a single subscription.
+void test_hub()
+{
+   std::cout << "test_hub" << std::endl;
+   using hub_type = aedis::experimental::hub<connection>;
+
+   net::io_context ioc;
+   auto db = std::make_shared<connection>(ioc);
+   db->get_config().enable_events = true;
+
+   hub_type hub{db};
+   hub_type::message_ptr msg1, msg2;
+
+   auto on_message = [&]() {
+      if (!msg1 || !msg2)
+         return;
+
+      expect_true(msg1 == msg2, "test_hub");
+      expect_eq(msg1->payload, std::string{"hub-message"}, "test_hub");
+      db->cancel_event_receiver();
+      db->cancel_run();
+   };
+
+   hub.subscribe("hub-channel", ioc.get_executor(), [&](auto msg) { msg1 = msg; on_message(); });
+   hub.subscribe("hub-channel", ioc.get_executor(), [&](auto msg) { msg2 = msg; on_message(); });
+   expect_eq(hub.channels(), std::size_t{1}, "test_hub");
+
+   hub.async_receive([](auto ec) {
+      expect_error(ec, boost::asio::experimental::channel_errc::channel_cancelled, "test_hub");
+   });
+
+   db->async_run([](auto) { });
+
+   // Gives the hub some time to subscribe before publishing.
+   request req;
+   req.push("PUBLISH", "hub-channel", "hub-message");
+   net::steady_timer timer{ioc, std::chrono::seconds{1}};
+   timer.async_wait([&](auto) {
+      db->async_exec(req, aedis::adapt(), [](auto ec, auto) {
+         expect_no_error(ec, "test_hub");
+      });
+   });
+
+   ioc.run();
+   expect_true(msg1 && msg2, "test_hub");
+}
+
 #ifdef BOOST_ASIO_HAS_CO_AWAIT
 net::awaitable<void>
 push_consumer1(std::shared_ptr<connection> db, bool& received, char const* msg)
@@ -286,6 +915,14 @@ net::awaitable<void> test_reconnect_impl(std::shared_ptr<connection> db)
 
    for (auto i = 0;;) {
       auto ev = co_await db->async_receive_event(aedis::adapt(), net::use_awaitable);
+      if (i != 0) {
+         expect_eq(ev, connection::event::reconnect, "test_reconnect.");
+         auto const& info = db->get_reconnect_info();
+         expect_eq(info.attempt, std::size_t{1}, "test_reconnect.");
+         expect_true(info.delay <= db->get_config().reconnect_interval, "test_reconnect.");
+         ev = co_await db->async_receive_event(aedis::adapt(), net::use_awaitable);
+      }
+
       expect_eq(ev, connection::event::resolve, "test_reconnect.");
 
        ev = co_await db->async_receive_event(aedis::adapt(), net::use_awaitable);
@@ -410,13 +1047,28 @@ int main()
 {
    test_resolve();
    test_connect();
+   test_resolve_cache_fallback();
    test_quit();
+   test_init();
+   test_init_error();
+   test_submitter();
+   test_exec_batch();
+   test_exec_batch_error();
+   test_sync_connection();
+   test_external_arg();
+   test_allocator_request();
+   test_unix_socket();
+   test_command_info();
    test_push();
+   test_hub();
 #ifdef BOOST_ASIO_HAS_CO_AWAIT
    test_reconnect();
 #endif
 
    // Must come last as it sends a client pause.
    test_idle();
+   test_health_check_busy();
+   test_health_check_idle();
+   test_tracer();
 }
 
@@ -0,0 +1,96 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+// Compiled with -DAEDIS_ENABLE_LATENCY_HISTOGRAMS, see
+// aedis::latency_histograms.
+#if !defined(AEDIS_ENABLE_LATENCY_HISTOGRAMS)
+#error "Compile with -DAEDIS_ENABLE_LATENCY_HISTOGRAMS."
+#endif
+
+#include <tuple>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <boost/asio.hpp>
+
+#include <aedis.hpp>
+#include <aedis/src.hpp>
+
+#include "check.hpp"
+#include "server.hpp"
+
+namespace net = boost::asio;
+
+using net::ip::tcp;
+using aedis::adapt;
+using aedis::latency_phase;
+using aedis::resp3::request;
+using connection = aedis::connection<>;
+
+// Tests the phases of requests whose responses are read in sequence,
+// all but the first are resumed by the previous request instead of
+// the reader.
+void test_pipeline()
+{
+   std::cout << "test_pipeline" << std::endl;
+
+   net::io_context sioc;
+   tcp::acceptor acceptor{sioc, {net::ip::make_address("127.0.0.1"), 0}};
+   std::thread server{[&]() {
+      auto socket = acceptor.accept();
+      serve_redis(socket);
+   }};
+
+   connection::config cfg;
+   cfg.port = std::to_string(acceptor.local_endpoint().port());
+
+   net::io_context ioc;
+   connection db{ioc, cfg};
+
+   // Executed before async_run so that they are written together.
+   std::size_t constexpr n = 10;
+   std::vector<request> reqs(n);
+   std::vector<std::tuple<std::string>> resps(n);
+   for (std::size_t i = 0; i < n; ++i) {
+      reqs[i].push("PING", std::to_string(i));
+      db.async_exec(reqs[i], adapt(resps[i]), [](auto ec, auto) {
+         expect_no_error(ec, "test_pipeline.exec");
+      });
+   }
+
+   request quit;
+   quit.push("QUIT");
+   db.async_exec(quit, adapt(), [](auto ec, auto) {
+      expect_no_error(ec, "test_pipeline.quit");
+   });
+
+   db.async_run([](auto ec) {
+      expect_error(ec, net::error::misc_errors::eof, "test_pipeline.run");
+   });
+
+   ioc.run();
+   server.join();
+
+   expect_eq(std::get<0>(resps.back()), std::to_string(n - 1), "test_pipeline.ping");
+
+   auto const& hists = db.get_latency_histograms();
+   auto const& total = hists[latency_phase::total];
+   expect_eq(total.count(), std::uint64_t{n + 1}, "test_pipeline.count");
+
+   for (auto p: {latency_phase::queue, latency_phase::write, latency_phase::server, latency_phase::parse}) {
+      auto const& h = hists[p];
+      std::string const msg = std::string{"test_pipeline."} + aedis::to_string(p);
+      expect_eq(h.count(), total.count(), msg + ".count");
+      expect_true(h.max() <= total.max(), msg + ".max");
+      expect_true(h.percentile(50) <= total.percentile(50), msg + ".p50");
+   }
+}
+
+int main()
+{
+   test_pipeline();
+}
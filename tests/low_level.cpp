@@ -5,8 +5,19 @@
  */
 
 #include <map>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <optional>
+#include <memory_resource>
 
 #include <boost/system/errc.hpp>
 #include <boost/asio/awaitable.hpp>
@@ -14,12 +25,16 @@
 #include <boost/asio/use_awaitable.hpp>
 #include <boost/asio/detached.hpp>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/experimental/deferred.hpp>
 #include <boost/beast/_experimental/test/stream.hpp>
 
 #include <aedis.hpp>
+#include <aedis/experimental/detail/submission.hpp>
+#include <aedis/experimental/hub.hpp>
 #include <aedis/src.hpp>
 
 #include "check.hpp"
+#include "command_info.hpp"
 #include "config.h"
 
 namespace net = boost::asio;
@@ -29,6 +44,21 @@ using test_stream = boost::beast::test::stream;
 using aedis::adapter::adapt;
 using node_type = aedis::resp3::node<std::string>;
 
+// Counts heap allocations, see test_fair_queue and test_request_pool.
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(std::size_t n)
+{
+   ++allocations;
+   if (auto* p = std::malloc(n == 0 ? 1 : n))
+      return p;
+
+   throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
 //-------------------------------------------------------------------
 
 template <class Result>
@@ -686,6 +716,933 @@ void test_null(net::io_context& ioc)
    test_async(ex, in09);
 }
 
+void test_hash_slot()
+{
+   expect_eq(aedis::hash_slot("foo"), std::size_t{12182}, "hash_slot.foo");
+   expect_eq(aedis::hash_slot("somekey"), std::size_t{11058}, "hash_slot.somekey");
+   expect_eq(aedis::hash_slot("{user1000}.following"), aedis::hash_slot("user1000"), "hash_slot.hash_tag");
+   expect_eq(aedis::hash_slot("foo{}{bar}"), std::size_t{8363}, "hash_slot.empty_hash_tag");
+   expect_eq(aedis::hash_slot("foo{{bar}}zap"), aedis::hash_slot("{bar"), "hash_slot.nested_hash_tag");
+}
+
+void test_push_commands()
+{
+   resp3::request req;
+   req.push("SSUBSCRIBE", "channel");
+   req.push("SUNSUBSCRIBE", "channel");
+   req.push("PSUBSCRIBE", "channel*");
+   req.push("PUNSUBSCRIBE", "channel*");
+   expect_eq(req.size(), std::size_t{0}, "request.push_commands");
+
+   req.push("SPUBLISH", "channel", "message");
+   expect_eq(req.size(), std::size_t{1}, "request.push_commands");
+}
+
+void test_compose_integers()
+{
+   resp3::request req;
+   req.push("CMD", -12, true, 'a', std::numeric_limits<std::uint64_t>::max());
+   req.push("CMD", std::numeric_limits<std::int64_t>::min());
+
+   std::string const expected =
+      "*5\r\n$3\r\nCMD\r\n$3\r\n-12\r\n$1\r\n1\r\n$2\r\n97\r\n$20\r\n18446744073709551615\r\n"
+      "*2\r\n$3\r\nCMD\r\n$20\r\n-9223372036854775808\r\n";
+
+   expect_eq(req.payload(), expected, "compose.integers");
+}
+
+void test_compose_pairs()
+{
+   resp3::request req;
+   req.push("HSET", "key", std::make_pair("field", 1), std::make_pair(std::string{"f"}, "v"));
+
+   std::string const expected =
+      "*6\r\n$4\r\nHSET\r\n$3\r\nkey\r\n$5\r\nfield\r\n$1\r\n1\r\n$1\r\nf\r\n$1\r\nv\r\n";
+
+   expect_eq(req.payload(), expected, "compose.pairs");
+
+   resp3::request typed;
+   typed.hset("key", std::make_pair("field", 1), std::make_pair(std::string{"f"}, "v"));
+   expect_eq(typed.payload(), expected, "compose.pairs.typed");
+}
+
+void test_prepared_command()
+{
+   resp3::prepared_command const hincrby{"HINCRBY  stats:{}:total field {}"};
+   expect_eq(hincrby.slots(), std::size_t{2}, "prepared_command.slots");
+
+   resp3::request req1;
+   req1.push(hincrby, "user1", 1);
+   req1.push(hincrby, std::string{"user22"}, -300);
+
+   resp3::request req2;
+   req2.push("HINCRBY", "stats:user1:total", "field", 1);
+   req2.push("HINCRBY", "stats:user22:total", "field", -300);
+
+   expect_eq(req1.payload(), req2.payload(), "prepared_command.payload");
+   expect_eq(req1.size(), std::size_t{2}, "prepared_command.size");
+
+   resp3::prepared_command const subscribe{"SUBSCRIBE {}"};
+   req1.push(subscribe, "channel");
+   expect_eq(req1.size(), std::size_t{2}, "prepared_command.push");
+
+   resp3::prepared_command const ping{"PING"};
+   resp3::request req3;
+   req3.push(ping);
+   expect_eq(req3.payload(), std::string{"*1\r\n$4\r\nPING\r\n"}, "prepared_command.no_slots");
+
+   // Too few or too many arguments leave the request unchanged.
+   auto const mismatch = [&](auto const&... args) {
+      try {
+         req3.push(hincrby, args...);
+      } catch (std::invalid_argument const&) {
+         return req3.payload() == "*1\r\n$4\r\nPING\r\n" && req3.size() == 1;
+      }
+      return false;
+   };
+
+   expect_true(mismatch("user1"), "prepared_command.too_few");
+   expect_true(mismatch("user1", 1, 2), "prepared_command.too_many");
+}
+
+void test_external_args(net::io_context& ioc)
+{
+   auto const value = std::make_shared<std::string>(1000, 'v');
+
+   resp3::request req1;
+   req1.push("SET", "key", resp3::external(net::buffer(*value), value), "EX", 2);
+   req1.push("GET", "key");
+   expect_eq(req1.externals().size(), std::size_t{1}, "external_args.externals");
+   expect_eq(req1.external_size(), std::size_t{1000}, "external_args.size");
+
+   resp3::request req2;
+   req2.push("SET", "key", *value, "EX", 2);
+   req2.push("GET", "key");
+
+   std::string flat;
+   req1.for_each_buffer([&](auto const& b) {
+      flat.append(static_cast<char const*>(b.data()), b.size());
+   });
+   expect_eq(flat, req2.payload(), "external_args.buffers");
+
+   // The commands are parsed as if the value was in the payload.
+   std::vector<std::string> args;
+   aedis::detail::for_each_command(req1.payload(), req1.externals(), [&](auto const& cmd) {
+      args.emplace_back(cmd.args[2].data(), cmd.args[2].size());
+   });
+   expect_eq(args.size(), std::size_t{2}, "external_args.commands");
+   expect_eq(args.front(), *value, "external_args.value");
+
+   // Gather write.
+   test_stream ts{ioc};
+   test_stream peer{ioc};
+   ts.connect(peer);
+   resp3::write(ts, req1);
+   expect_eq(std::string{peer.str()}, req2.payload(), "external_args.write");
+
+   // async_write has a single return type with and without external
+   // arguments, which tokens like deferred need.
+   net::io_context wioc;
+   test_stream ts2{wioc};
+   test_stream peer2{wioc};
+   ts2.connect(peer2);
+   auto const deferred_write = [&](auto const& req) {
+      return resp3::async_write(ts2, req, net::experimental::deferred);
+   };
+
+   deferred_write(req1)([&](auto ec, auto n) {
+      expect_no_error(ec, "external_args.deferred");
+      expect_eq(n, req2.payload().size(), "external_args.deferred.size");
+      deferred_write(req2)([&](auto ec, auto) {
+         expect_no_error(ec, "external_args.deferred.payload");
+         expect_eq(std::string{peer2.str()}, req2.payload() + req2.payload(), "external_args.deferred.write");
+      });
+   });
+
+   wioc.run();
+
+   // The header of input ranges is written after counting.
+   std::istringstream in{"a b c"};
+   resp3::request req3;
+   req3.push_range2("RPUSH", "list", std::istream_iterator<std::string>{in}, std::istream_iterator<std::string>{});
+
+   std::vector<std::string> const list{"a", "b", "c"};
+   resp3::request req4;
+   req4.push_range("RPUSH", "list", list);
+   expect_eq(req3.payload(), req4.payload(), "external_args.input_range");
+   expect_eq(req3.size(), std::size_t{1}, "external_args.input_range_size");
+}
+
+void test_reconnect_policy()
+{
+   using namespace std::chrono_literals;
+
+   aedis::reconnect_policy policy{100ms, 1000ms, true};
+   expect_true(policy.next() <= 100ms, "reconnect_policy.fast_first_retry");
+
+   bool in_bounds = true;
+   for (auto i = 0; i < 100; ++i) {
+      auto const d = policy.next();
+      in_bounds = in_bounds && 100ms <= d && d <= 1000ms;
+   }
+
+   expect_true(in_bounds, "reconnect_policy.bounds");
+
+   expect_eq(policy.attempts(), std::size_t{101}, "reconnect_policy.attempts");
+
+   policy.reset();
+   expect_eq(policy.attempts(), std::size_t{0}, "reconnect_policy.reset");
+   expect_true(policy.next() <= 100ms, "reconnect_policy.reset");
+
+   aedis::reconnect_policy slow{100ms, 1000ms, false};
+   expect_true(slow.next() >= 100ms, "reconnect_policy.slow_first_retry");
+}
+
+void test_timer_wheel()
+{
+   using namespace std::chrono_literals;
+
+   struct counter {
+      aedis::timer_wheel* wheel;
+      int fired = 0;
+      aedis::timer_wheel::entry entry{[](void* p) {
+         auto* self = static_cast<counter*>(p);
+         if (++self->fired < 3)
+            self->wheel->arm(self->entry, 20ms);
+      }, this};
+   };
+
+   net::io_context ioc;
+   auto wheel = std::make_shared<aedis::timer_wheel>(ioc.get_executor(), 10ms);
+
+   counter c1{wheel.get()};
+   counter c2{wheel.get()};
+   wheel->arm(c1.entry, 10ms);
+   wheel->arm(c2.entry, 3000ms);
+   expect_eq(wheel->size(), std::size_t{2}, "timer_wheel.arm");
+
+   c2.entry.cancel();
+   expect_eq(wheel->size(), std::size_t{1}, "timer_wheel.cancel");
+
+   ioc.run();
+   expect_eq(c1.fired, 3, "timer_wheel.rearm");
+   expect_eq(c2.fired, 0, "timer_wheel.cancel");
+   expect_eq(wheel->size(), std::size_t{0}, "timer_wheel.empty");
+}
+
+void test_resolve_cache()
+{
+   using endpoints_type = aedis::resolve_cache::endpoints_type;
+
+   endpoints_type const eps{{net::ip::make_address("127.0.0.1"), 6379}};
+   endpoints_type out;
+
+   aedis::resolve_cache cache{std::chrono::seconds{30}};
+   expect_eq(cache.find("localhost", "6379", out), false, "resolve_cache.miss");
+
+   cache.insert("localhost", "6379", eps);
+   expect_eq(cache.find("localhost", "6379", out), true, "resolve_cache.hit");
+   expect_eq(out == eps, true, "resolve_cache.endpoints");
+   expect_eq(cache.find("localhost", "6380", out), false, "resolve_cache.port");
+
+   cache.mark_stale("localhost", "6379");
+   expect_eq(cache.find("localhost", "6379", out), false, "resolve_cache.mark_stale");
+   expect_eq(cache.find("localhost", "6379", out, true), true, "resolve_cache.mark_stale.fallback");
+   expect_eq(cache.size(), std::size_t{1}, "resolve_cache.mark_stale.size");
+
+   cache.erase("localhost", "6379");
+   expect_eq(cache.size(), std::size_t{0}, "resolve_cache.erase");
+
+   // Expired entries are only returned when stale ones are accepted.
+   aedis::resolve_cache expired{std::chrono::seconds{0}};
+   expired.insert("localhost", "6379", eps);
+   expect_eq(expired.find("localhost", "6379", out), false, "resolve_cache.expired");
+   expect_eq(expired.find("localhost", "6379", out, true), true, "resolve_cache.stale");
+}
+
+void test_literal_endpoint()
+{
+   using aedis::detail::make_literal_endpoint;
+
+   net::ip::tcp::endpoint ep;
+   expect_true(make_literal_endpoint("127.0.0.1", "6379", ep), "literal_endpoint.v4");
+   expect_eq(ep, net::ip::tcp::endpoint{net::ip::make_address("127.0.0.1"), 6379}, "literal_endpoint.v4.endpoint");
+
+   expect_true(make_literal_endpoint("::1", "6380", ep), "literal_endpoint.v6");
+   expect_eq(ep, net::ip::tcp::endpoint{net::ip::make_address("::1"), 6380}, "literal_endpoint.v6.endpoint");
+
+   expect_true(make_literal_endpoint("[fe80::1]", "1", ep), "literal_endpoint.bracketed");
+   expect_eq(ep, net::ip::tcp::endpoint{net::ip::make_address("fe80::1"), 1}, "literal_endpoint.bracketed.endpoint");
+
+   expect_true(!make_literal_endpoint("localhost", "6379", ep), "literal_endpoint.name");
+   expect_true(!make_literal_endpoint("[127.0.0.1", "6379", ep), "literal_endpoint.bracket");
+   expect_true(!make_literal_endpoint("[]", "6379", ep), "literal_endpoint.empty_brackets");
+   expect_true(!make_literal_endpoint("127.0.0.1", "redis", ep), "literal_endpoint.service");
+   expect_true(!make_literal_endpoint("127.0.0.1", "65536", ep), "literal_endpoint.port_range");
+   expect_true(!make_literal_endpoint("127.0.0.1", "", ep), "literal_endpoint.no_port");
+}
+
+void test_interleave_families()
+{
+   using endpoint = net::ip::tcp::endpoint;
+   auto const ep = [](char const* a) { return endpoint{net::ip::make_address(a), 6379}; };
+
+   std::vector<endpoint> const resolved
+      { ep("::1"), ep("::2"), ep("::3"), ep("10.0.0.1"), ep("10.0.0.2")};
+   auto const res = net::ip::tcp::resolver::results_type::create(
+      std::cbegin(resolved), std::cend(resolved), "host", "6379");
+
+   std::vector<endpoint> const expected
+      { ep("::1"), ep("10.0.0.1"), ep("::2"), ep("10.0.0.2"), ep("::3")};
+   expect_eq(aedis::detail::interleave_families(res), expected, "interleave_families.v6_first");
+
+   std::vector<endpoint> const resolved2 {ep("10.0.0.1"), ep("10.0.0.2"), ep("::1")};
+   auto const res2 = net::ip::tcp::resolver::results_type::create(
+      std::cbegin(resolved2), std::cend(resolved2), "host", "6379");
+
+   std::vector<endpoint> const expected2 {ep("10.0.0.1"), ep("::1"), ep("10.0.0.2")};
+   expect_eq(aedis::detail::interleave_families(res2), expected2, "interleave_families.v4_first");
+}
+
+// Returns a local endpoint on which connections are refused.
+net::ip::tcp::endpoint make_refusing_endpoint(net::io_context& ioc)
+{
+   net::ip::tcp::acceptor acceptor{ioc, {net::ip::make_address("127.0.0.1"), 0}};
+   auto const ep = acceptor.local_endpoint();
+   acceptor.close();
+   return ep;
+}
+
+// Tests whether a failed attempt starts the next one without waiting
+// for the attempt delay, and the error of the last attempt when all
+// of them fail.
+void test_happy_eyeballs()
+{
+   using namespace std::chrono_literals;
+   using timer_type = aedis::detail::conn_timer_t<net::any_io_executor>;
+
+   net::io_context ioc;
+   net::ip::tcp::acceptor acceptor{ioc, {net::ip::make_address("127.0.0.1"), 0}};
+   std::vector<net::ip::tcp::endpoint> const eps
+      {make_refusing_endpoint(ioc), acceptor.local_endpoint()};
+
+   net::ip::tcp::socket socket{ioc};
+   timer_type timer{ioc};
+   timer.expires_after(10s);
+
+   auto const delay = 2000ms;
+   auto const start = std::chrono::steady_clock::now();
+   aedis::detail::async_connect(socket, timer, eps, delay, [&](auto ec) {
+      expect_no_error(ec, "happy_eyeballs.second");
+      expect_true(std::chrono::steady_clock::now() - start < delay, "happy_eyeballs.no_delay");
+      expect_eq(socket.remote_endpoint(), eps.back(), "happy_eyeballs.endpoint");
+   });
+
+   ioc.run();
+
+   std::vector<net::ip::tcp::endpoint> const refusing
+      {make_refusing_endpoint(ioc), make_refusing_endpoint(ioc)};
+
+   net::ip::tcp::socket socket2{ioc};
+   timer.expires_after(10s);
+   aedis::detail::async_connect(socket2, timer, refusing, delay, [&](auto ec) {
+      expect_error(ec, net::error::connection_refused, "happy_eyeballs.all_fail");
+      expect_true(!socket2.is_open(), "happy_eyeballs.all_fail.closed");
+   });
+
+   ioc.restart();
+   ioc.run();
+}
+
+void test_latency_histogram()
+{
+   using namespace std::chrono_literals;
+
+   aedis::latency_histogram h;
+   expect_eq(h.percentile(50), 0ns, "latency_histogram.empty");
+
+   for (int i = 1; i <= 100; ++i)
+      h.record(std::chrono::microseconds{i});
+
+   // Values are reported with a relative error below 1/16.
+   auto const p50 = h.percentile(50);
+   expect_eq(p50 >= 50us && p50 < 50us + 50us / 16, true, "latency_histogram.p50");
+   expect_eq(h.percentile(100), std::chrono::nanoseconds{100us}, "latency_histogram.max");
+   expect_eq(h.count(), std::uint64_t{100}, "latency_histogram.count");
+
+   aedis::latency_histogram other;
+   other.record(1s);
+   h.merge(other);
+   expect_eq(h.max(), std::chrono::nanoseconds{1s}, "latency_histogram.merge");
+
+   h.reset();
+   expect_eq(h.count(), std::uint64_t{0}, "latency_histogram.reset");
+
+   // Values up to 2^37ns, about 137s, are tracked, larger ones are
+   // counted in the last bucket.
+   h.record(100s);
+   h.record(137s);
+   h.record(300s);
+   std::vector<std::pair<std::chrono::nanoseconds, std::uint64_t>> buckets;
+   h.for_each_bucket([&](auto d, auto n) { buckets.push_back({d, n}); });
+   expect_eq(buckets.size(), std::size_t{2}, "latency_histogram.range.buckets");
+   expect_eq(buckets.back().first, std::chrono::nanoseconds{(std::int64_t{1} << 37) - 1}, "latency_histogram.range.top");
+   expect_eq(buckets.back().second, std::uint64_t{2}, "latency_histogram.range.last");
+}
+
+void test_stats()
+{
+   aedis::detail::stats_counters counters;
+   aedis::detail::stats_counters::add(counters.requests_queued, 3);
+   aedis::detail::stats_counters::add(counters.requests_completed);
+   counters.on_batch(2);
+   counters.on_batch(1);
+
+   auto const st = counters.snapshot();
+   expect_eq(st.requests_in_flight, std::uint64_t{2}, "stats.in_flight");
+   expect_eq(st.batched_requests, std::uint64_t{3}, "stats.batched_requests");
+   expect_eq(st.max_batch_size, std::uint64_t{2}, "stats.max_batch_size");
+
+   auto const text = aedis::to_prometheus({{"a\"b", st}});
+   expect_neq(text.find("# TYPE aedis_requests_queued_total counter\n"), std::string::npos, "stats.prometheus.type");
+   expect_neq(text.find("aedis_requests_in_flight{connection=\"a\\\"b\"} 2\n"), std::string::npos, "stats.prometheus.sample");
+}
+
+void test_diagnostics()
+{
+   resp3::request req;
+   req.push("SET", "key", "value");
+   req.push("GET", "key");
+
+   std::size_t cmds = 0;
+   aedis::detail::for_each_command(req.payload(), [&](auto const& cmd) {
+      expect_eq(cmd.args[1], boost::string_view{"key"}, "for_each_command.key");
+      ++cmds;
+   });
+   expect_eq(cmds, std::size_t{2}, "for_each_command.size");
+
+   aedis::hot_keys keys{2, 1};
+   keys.add("a", 5);
+   keys.add("b", 3);
+   keys.add("c");
+   auto const top = keys.top(2);
+   expect_eq(top.at(0).key, std::string{"a"}, "hot_keys.top");
+   expect_eq(top.at(1).key, std::string{"c"}, "hot_keys.replace");
+   expect_eq(top.at(1).error, std::uint64_t{3}, "hot_keys.error");
+
+   // One in four requests is sampled, its counts are scaled back.
+   aedis::hot_keys sampled{4, 4};
+   std::vector<std::thread> threads;
+   for (int i = 0; i < 4; ++i)
+      threads.emplace_back([&]() { for (int j = 0; j < 100; ++j) sampled.sample(req); });
+   for (auto& t: threads)
+      t.join();
+   expect_eq(sampled.top(1).at(0).count, std::uint64_t{800}, "hot_keys.sample_rate");
+
+   aedis::slow_log ring{std::chrono::microseconds{0}, 2};
+   for (auto const* cmd: {"A", "B", "C"}) {
+      aedis::slow_request sr;
+      sr.command = cmd;
+      ring.add(sr);
+   }
+   auto const entries = ring.entries();
+   expect_eq(entries.at(0).command, std::string{"B"}, "slow_log.oldest");
+   expect_eq(ring.total(), std::uint64_t{3}, "slow_log.total");
+
+   auto log = std::make_shared<aedis::slow_log>(std::chrono::microseconds{-1});
+   aedis::diagnostics_tracer tracer;
+   tracer.set_slow_log(log);
+   tracer.on_exec(req);
+   tracer.on_write_begin(req, req.payload().size());
+   tracer.on_response_end(req, {}, 10);
+   expect_eq(log->entries().at(0).command, std::string{"SET"}, "diagnostics_tracer.command");
+   expect_eq(log->entries().at(0).args, std::string{"key value"}, "diagnostics_tracer.args");
+
+   // Requests are written in lane order, not in the order of exec.
+   resp3::request other;
+   other.push("GET", "other");
+   log->clear();
+   tracer.on_exec(req);
+   tracer.on_exec(other);
+   tracer.on_write_begin(other, other.payload().size());
+   tracer.on_write_begin(req, req.payload().size());
+   tracer.on_response_end(other, {}, 10);
+   tracer.on_response_end(req, {}, 10);
+   tracer.on_response_end(req, {}, 10);
+   expect_eq(log->entries().size(), std::size_t{2}, "diagnostics_tracer.pending");
+   expect_eq(log->entries().at(0).args, std::string{"other"}, "diagnostics_tracer.order");
+}
+
+void test_recording_stream(net::io_context& ioc)
+{
+   auto const path = std::string{"aedis_test_recording.bin"};
+   auto rec = std::make_shared<aedis::traffic_recorder>(path);
+
+   // Writes go to the peer, reads come from the input of the stream.
+   auto peer = std::make_shared<test_stream>(ioc);
+   auto rs = std::make_shared<aedis::recording_stream<test_stream>>(ioc, rec);
+   rs->next_layer().connect(*peer);
+   rs->next_layer().append("+PONG\r\n");
+
+   auto ping = std::make_shared<std::string>("*1\r\n$4\r\nPING\r\n");
+   net::async_write(*rs, net::buffer(*ping), [peer, ping](auto ec, auto) {
+      expect_no_error(ec, "recording_stream.write");
+   });
+
+   auto buffer = std::make_shared<std::string>();
+   resp3::async_read(*rs, net::dynamic_buffer(*buffer), adapt(), [rs, rec, buffer, path](auto ec, auto) {
+      expect_no_error(ec, "recording_stream.read");
+      rec->flush();
+
+      aedis::traffic_reader reader{path};
+      aedis::traffic_record r;
+      reader.next(r);
+      expect_eq(r.direction, aedis::traffic_direction::connection, "recording_stream.connection");
+      reader.next(r);
+      expect_eq(r.direction, aedis::traffic_direction::sent, "recording_stream.sent");
+      expect_eq(r.data, std::string{"*1\r\n$4\r\nPING\r\n"}, "recording_stream.sent_data");
+      reader.next(r);
+      expect_eq(r.direction, aedis::traffic_direction::received, "recording_stream.received");
+      expect_eq(r.data, std::string{"+PONG\r\n"}, "recording_stream.received_data");
+      std::remove(path.c_str());
+   });
+}
+
+void test_fair_queue()
+{
+   // Pairs of tenant and sequence number.
+   using elem_type = std::pair<std::size_t, int>;
+   aedis::detail::fair_queue<elem_type, 3> queue;
+
+   auto const weight = [](std::size_t t) { return t == 0 ? std::size_t{2} : std::size_t{1}; };
+   auto const push = [&](std::size_t lane, elem_type e) { queue.push_back(lane, e.first, weight(e.first), e); };
+   auto const pop_all = [&]() {
+      std::vector<elem_type> ret;
+      while (!queue.empty())
+         ret.push_back(queue.pop());
+      return ret;
+   };
+
+   for (auto const& e: std::vector<elem_type>{{0, 0}, {0, 1}, {0, 2}, {0, 3}, {1, 0}, {1, 1}, {2, 0}, {0, 4}})
+      push(1, e);
+
+   std::vector<elem_type> const expected
+      {{0, 0}, {0, 1}, {1, 0}, {2, 0}, {0, 2}, {0, 3}, {1, 1}, {0, 4}};
+   expect_eq(pop_all(), expected, "fair_queue");
+
+   // Lower lanes first.
+   push(2, {3, 0});
+   push(1, {3, 1});
+   push(0, {3, 2});
+   expect_eq(pop_all(), std::vector<elem_type>{{3, 2}, {3, 1}, {3, 0}}, "fair_queue.lanes");
+
+   // The cursor persists across pops, a new tenant waits for its turn.
+   push(1, {0, 0});
+   push(1, {0, 1});
+   push(1, {0, 2});
+   push(1, {1, 0});
+   expect_eq(queue.pop(), elem_type{0, 0}, "fair_queue.cursor");
+   push(1, {2, 0});
+   push(1, {0, 3});
+   queue.push_front(1, 1, 1, {1, -1});
+   expect_eq(pop_all(), std::vector<elem_type>{{0, 1}, {1, -1}, {2, 0}, {0, 2}, {0, 3}, {1, 0}}, "fair_queue.push");
+
+   // Removing the tenant being served moves to the next.
+   push(1, {0, 0});
+   push(1, {1, 0});
+   push(1, {1, 1});
+   push(1, {2, 0});
+   expect_eq(queue.pop(), elem_type{0, 0}, "fair_queue.remove_if.pop");
+   queue.remove_if([](auto const& e) { return e.first == 1; });
+   expect_eq(queue.size(), std::size_t{1}, "fair_queue.remove_if.size");
+   expect_eq(pop_all(), std::vector<elem_type>{{2, 0}}, "fair_queue.remove_if");
+
+   // A tenant keeps its queue when it becomes empty, as when a single
+   // tenant executes one request after the other.
+   aedis::detail::fair_queue<std::shared_ptr<int>, 3> ptrs;
+   auto const elem = std::make_shared<int>(0);
+   ptrs.push_back(1, 7, 1, elem);
+   ptrs.pop();
+
+   auto const before = allocations.load();
+   for (int i = 0; i < 1000; ++i) {
+      ptrs.push_back(1, 7, 1, elem);
+      ptrs.push_front(1, 7, 1, elem);
+      ptrs.pop();
+      ptrs.pop();
+   }
+
+   auto const allocated = allocations.load() - before;
+   expect_eq(allocated, std::size_t{0}, "fair_queue.allocations");
+   expect_true(ptrs.empty(), "fair_queue.allocations.empty");
+}
+
+void test_coalescing_policy()
+{
+   using namespace std::chrono_literals;
+   using ns = std::chrono::nanoseconds;
+
+   aedis::coalescing_policy disabled;
+   expect_eq(disabled.window(0, 1), ns{0}, "coalescing_policy.disabled");
+
+   aedis::coalescing_policy p{100us, 1024, 10};
+   std::chrono::steady_clock::time_point now;
+   for (int i = 0; i < 4; ++i) {
+      now += 10us;
+      p.on_arrival(now);
+   }
+   expect_eq(p.window(0, 1), ns{0}, "coalescing_policy.no_rtt");
+
+   p.on_round_trip(200us);
+   expect_eq(p.mean_gap(), ns{10us}, "coalescing_policy.gap");
+   expect_eq(p.window(0, 1), ns{50us}, "coalescing_policy.rtt_bound");
+   expect_eq(p.window(0, 8), ns{20us}, "coalescing_policy.fill_bound");
+   expect_eq(p.window(0, 10), ns{0}, "coalescing_policy.full_commands");
+   expect_eq(p.window(1024, 1), ns{0}, "coalescing_policy.full_bytes");
+
+   // Low load.
+   for (int i = 0; i < 32; ++i) {
+      now += 10ms;
+      p.on_arrival(now);
+   }
+   expect_eq(p.window(0, 1), ns{0}, "coalescing_policy.low_load");
+}
+
+// Replays events to an experimental::hub and records its requests.
+struct fake_hub_connection {
+   enum class event { resolve, connect, hello, push, reconnect, invalid };
+   using executor_type = net::io_context::executor_type;
+   using default_completion_token_type = net::default_completion_token_t<executor_type>;
+   using node_view = resp3::node<boost::string_view>;
+
+   explicit fake_hub_connection(net::io_context& ioc) : ioc{ioc} {}
+
+   executor_type get_executor() { return ioc.get_executor(); }
+
+   template <class Adapter, class Handler>
+   void async_exec(resp3::request const& req, Adapter, Handler h)
+   {
+      written.emplace_back(req.payload());
+      net::post(ioc, [h = std::move(h)]() mutable { h(boost::system::error_code{}, std::size_t{0}); });
+   }
+
+   template <class Adapter, class Handler>
+   void async_receive_event(Adapter adapter, Handler h)
+   {
+      auto handler = std::make_shared<Handler>(std::move(h));
+      receiver = [adapter, handler](std::vector<node_view> const& nodes, boost::system::error_code ec, event ev) mutable {
+         for (auto const& nd: nodes)
+            adapter(0, nd, ec);
+         (*handler)(ec, ev);
+      };
+   }
+
+   void emit(event ev, std::vector<node_view> nodes = {}, boost::system::error_code ec = {})
+   {
+      auto r = std::move(receiver);
+      receiver = nullptr;
+      net::post(ioc, [r, ev, nodes, ec]() { r(nodes, ec, ev); });
+      ioc.poll();
+   }
+
+   void emit_push(boost::string_view type, boost::string_view channel, boost::string_view value)
+   {
+      emit(event::push,
+         { {resp3::type::push, 3, 0, {}}
+         , {resp3::type::blob_string, 1, 1, type}
+         , {resp3::type::blob_string, 1, 1, channel}
+         , {resp3::type::blob_string, 1, 1, value}
+         });
+   }
+
+   net::io_context& ioc;
+   std::vector<std::string> written;
+   std::function<void(std::vector<node_view> const&, boost::system::error_code, event)> receiver;
+};
+
+// Sharded channels dropped by the server are reported, not subscribed again.
+void test_hub_sunsubscribe()
+{
+   using event = fake_hub_connection::event;
+
+   net::io_context ioc;
+   auto conn = std::make_shared<fake_hub_connection>(ioc);
+   aedis::experimental::hub<fake_hub_connection> hub{conn};
+
+   std::vector<std::string> dropped;
+   hub.set_sunsubscribe_handler(ioc.get_executor(), [&](auto const& channel) { dropped.push_back(channel); });
+
+   std::size_t messages = 0;
+   auto const a = hub.ssubscribe("a", ioc.get_executor(), [&](auto) { ++messages; });
+   hub.ssubscribe("b", ioc.get_executor(), [&](auto) { ++messages; });
+   hub.async_receive([](auto ec) {
+      expect_error(ec, net::error::operation_aborted, "hub.sunsubscribe.receive");
+   });
+   ioc.poll();
+
+   conn->emit(event::hello);
+   expect_eq(conn->written.size(), std::size_t{1}, "hub.sunsubscribe.hello");
+
+   conn->emit_push("smessage", "b", "payload");
+   expect_eq(messages, std::size_t{1}, "hub.sunsubscribe.smessage");
+
+   // Confirmation of an unsubscription requested by the hub.
+   hub.sunsubscribe("a", a);
+   ioc.poll();
+   conn->emit_push("sunsubscribe", "a", "1");
+   expect_true(dropped.empty(), "hub.sunsubscribe.requested");
+
+   // Unsubscription by the server e.g. after a slot migration.
+   auto const writes = conn->written.size();
+   conn->emit_push("sunsubscribe", "b", "0");
+   expect_eq(dropped.size(), std::size_t{1}, "hub.sunsubscribe.reported");
+   expect_eq(dropped.at(0), std::string{"b"}, "hub.sunsubscribe.channel");
+   expect_eq(hub.channels(), std::size_t{0}, "hub.sunsubscribe.removed");
+   expect_eq(conn->written.size(), writes, "hub.sunsubscribe.no_resubscribe");
+
+   conn->emit_push("smessage", "b", "payload");
+   expect_eq(messages, std::size_t{1}, "hub.sunsubscribe.no_listeners");
+
+   conn->emit(event::invalid, {}, net::error::operation_aborted);
+}
+
+void test_submission_queue()
+{
+   namespace ed = aedis::experimental::detail;
+
+   struct item : ed::submission {
+      int value = 0;
+      ed::waiter done;
+   };
+
+   ed::submission_queue queue;
+   std::atomic<int> sum{0};
+   int const producers = 4;
+   int const items = 1000;
+
+   // Drains when woken, as the connection executor does.
+   std::atomic<bool> stop{false};
+   std::thread consumer{[&]() {
+      while (!stop) {
+         for (auto* s = queue.pop_all(); s != nullptr;) {
+            auto* it = static_cast<item*>(s);
+            s = s->next;
+            sum += it->value;
+            it->done.notify();
+         }
+      }
+   }};
+
+   std::vector<std::thread> threads;
+   for (int i = 0; i < producers; ++i) {
+      threads.emplace_back([&]() {
+         for (int j = 0; j < items; ++j) {
+            item it;
+            it.value = 1;
+            queue.push(&it);
+            it.done.wait();
+         }
+      });
+   }
+
+   for (auto& t: threads)
+      t.join();
+
+   stop = true;
+   consumer.join();
+
+   expect_eq(sum.load(), producers * items, "submission_queue.sum");
+
+   // Only the first push to an empty queue wakes the consumer up.
+   item a, b;
+   expect_eq(queue.push(&a), true, "submission_queue.wakeup");
+   expect_eq(queue.push(&b), false, "submission_queue.no_wakeup");
+
+   // Elements are returned in push order.
+   expect_eq(queue.pop_all(), static_cast<ed::submission*>(&a), "submission_queue.fifo");
+}
+
+void test_request_pool()
+{
+   resp3::request_pool pool{4, 1024};
+
+   auto build = [&]() {
+      auto req = pool.acquire();
+      req->push("HINCRBY", "stats:1234", "field", 1);
+      req->push("SET", "key", "value", "EX", 2);
+      req->push("PING");
+      return req;
+   };
+
+   // Warms the pool up.
+   build();
+   expect_eq(pool.size(), std::size_t{1}, "request_pool.size");
+
+   std::size_t commands = 0;
+   auto const before = allocations.load();
+   for (int i = 0; i < 1000; ++i)
+      commands += build()->size();
+
+   auto const allocated = allocations.load() - before;
+   expect_eq(allocated, std::size_t{0}, "request_pool.allocations");
+   expect_eq(commands, std::size_t{3000}, "request_pool.commands");
+
+   // Released requests are empty.
+   auto req = pool.acquire();
+   expect_eq(req->size(), std::size_t{0}, "request_pool.clear");
+   expect_true(req->payload().empty(), "request_pool.payload");
+   expect_true(req->capacity() != 0, "request_pool.capacity");
+   req.reset();
+
+   // Large requests are not kept.
+   {
+      auto big = pool.acquire();
+      big->push("SET", "key", std::string(4096, 'a'));
+   }
+   expect_eq(pool.size(), std::size_t{0}, "request_pool.max_capacity");
+}
+
+void test_request_view()
+{
+   // Commands do not fit in the small string buffer, the payload and
+   // the external arguments come from the stack buffer.
+   char buffer[512];
+   std::pmr::monotonic_buffer_resource resource{buffer, sizeof buffer};
+   resp3::basic_request<std::pmr::polymorphic_allocator<char>> req{&resource};
+   req.lane = resp3::priority_lane::low;
+   req.tenant = 3;
+
+   auto const before = allocations.load();
+   req.push("GET", "key");
+   req.push("SET", "key", resp3::external(net::buffer("value", 5)));
+   auto const allocated = allocations.load() - before;
+   expect_eq(allocated, std::size_t{0}, "request_view.allocations");
+
+   resp3::request_view const view{req};
+   expect_eq(view.size(), std::size_t{2}, "request_view.size");
+   expect_true(view.payload() == boost::string_view{req.payload().data(), req.payload().size()}, "request_view.payload");
+   expect_eq(view.external_size(), std::size_t{5}, "request_view.external_size");
+   expect_true(view.lane == resp3::priority_lane::low, "request_view.lane");
+   expect_eq(view.tenant, std::size_t{3}, "request_view.tenant");
+   expect_true(view.id() == resp3::request_view{req}.id(), "request_view.id");
+
+   resp3::request other;
+   other.append(req);
+   expect_eq(other.size(), std::size_t{2}, "request_view.append.size");
+   expect_true(other.payload() == std::string(req.payload().data(), req.payload().size()), "request_view.append.payload");
+   expect_eq(other.externals().at(0).offset, req.externals().at(0).offset, "request_view.append.externals");
+}
+
+void test_command_table()
+{
+   using resp3::command;
+   using resp3::command_kind;
+
+   static_assert(resp3::info(command::hgetall).kind == command_kind::readonly);
+   static_assert(resp3::find_command("SET")->id == command::set);
+   static_assert(!resp3::info(command::get).accepts(3));
+   static_assert(resp3::info(command::mset).accepts(5));
+
+   std::size_t found = 0;
+   for (std::size_t i = 0; i < resp3::detail::command_count; ++i) {
+      auto const& cmd = resp3::detail::command_infos[i];
+      if (resp3::find_command(cmd.name) == &cmd && static_cast<std::size_t>(cmd.id) == i)
+         ++found;
+   }
+   expect_eq(found, resp3::detail::command_count, "find_command.all");
+
+   // Names that are not in the table land in used slots too.
+   std::size_t false_positives = 0;
+   for (auto const& cmd: resp3::detail::command_infos) {
+      auto const name = std::string{cmd.name} + "X";
+      if (resp3::find_command(name) != nullptr)
+         ++false_positives;
+   }
+   expect_eq(false_positives, std::size_t{0}, "find_command.unknown_names");
+
+   expect_true(resp3::find_command("hgetall") == &resp3::info(command::hgetall), "find_command.case");
+   expect_true(resp3::find_command("HGETALLX") == nullptr, "find_command.unknown");
+   expect_true(resp3::find_command("") == nullptr, "find_command.empty");
+   expect_true(resp3::info(command::ssubscribe).has_push_response(), "command.push_response");
+   expect_true(!resp3::info(command::publish).has_push_response(), "command.response");
+
+   resp3::request expected;
+   expected.push("SET", "key", "value", "EX", 2);
+   expected.push("HGETALL", "key");
+   expected.push("HSET", "key", "f1", "v1", "f2", 2);
+   expected.push("DEL", "a", "b");
+   expected.push("SUBSCRIBE", "channel");
+
+   resp3::request req;
+   req.set("key", "value", "EX", 2);
+   req.hgetall("key");
+   req.hset("key", "f1", "v1", "f2", 2);
+   req.del("a", "b");
+   req.push<command::subscribe>("channel");
+
+   expect_eq(req.payload(), expected.payload(), "typed_builders.payload");
+   expect_eq(req.size(), std::size_t{4}, "typed_builders.size");
+
+   // Lookups are case insensitive.
+   resp3::request sub;
+   sub.push("subscribe", "channel");
+   expect_eq(sub.size(), std::size_t{0}, "has_push_response.case");
+
+   // Sharded channels and commands without key are not sampled.
+   resp3::request keys;
+   keys.push("PING");
+   keys.push("SPUBLISH", "channel", "message");
+   keys.push("RENAME", "a", "b");
+   keys.push("UNKNOWN", "c");
+   aedis::hot_keys hot{8, 1};
+   hot.sample(keys);
+   auto const top = hot.top(8);
+   expect_eq(top.size(), std::size_t{2}, "hot_keys.keyless");
+   auto const sampled = top.at(0).key + top.at(1).key;
+   expect_true(sampled == "ac" || sampled == "ca", "hot_keys.first_key");
+}
+
+/* Compares the command table with the output of COMMAND INFO of
+ * Redis 6.2.14 checked in as redis-6.2.14-command-info.resp. The
+ * table follows Redis 7.0, the commands below are new in 7.0 or have
+ * changed since 6.2 and are only checked by test_command_info in
+ * connection.cpp, against the server the tests run against.
+ */
+void test_command_info_capture(net::io_context& ioc)
+{
+   std::ifstream file{AEDIS_TESTS_DIR "/redis-6.2.14-command-info.resp", std::ios::binary};
+   std::string const capture{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+   expect_true(!capture.empty(), "command_info_capture.file");
+
+   test_stream ts{ioc};
+   ts.append(capture);
+
+   // Unknown commands are null, which the node adapter would report
+   // as an error.
+   std::vector<node_type> reply;
+   auto const collect = [&](resp3::node<boost::string_view> const& nd, boost::system::error_code&)
+      { reply.push_back({nd.data_type, nd.aggregate_size, nd.depth, std::string{nd.value}}); };
+
+   std::string buffer;
+   boost::system::error_code ec;
+   resp3::read(ts, net::dynamic_buffer(buffer), collect, ec);
+   expect_no_error(ec, "command_info_capture.read");
+
+   auto const res = compare_command_info(reply);
+
+   // Arities that grew options and commands that became containers
+   // of subcommands in 7.0.
+   std::vector<std::string> const changed
+      {"EXPIRE", "EXPIREAT", "MEMORY", "OBJECT", "PEXPIRE", "XGROUP"};
+   expect_eq(res.mismatches, changed, "command_info_capture.mismatches");
+
+   // QUIT was not in the command table before 7.0.
+   std::vector<std::string> const added
+      { "EVALSHA_RO", "EVAL_RO", "EXPIRETIME", "FCALL", "FCALL_RO"
+      , "FUNCTION", "QUIT", "SPUBLISH", "SSUBSCRIBE", "SUNSUBSCRIBE"};
+   expect_eq(res.unknown, added, "command_info_capture.unknown");
+}
+
 int main()
 {
    net::io_context ioc {1};
@@ -712,6 +1669,32 @@ int main()
    // RESP3
    test_resp3(ioc);
 
+   // Requests.
+   test_push_commands();
+   test_compose_integers();
+   test_compose_pairs();
+   test_prepared_command();
+   test_external_args(ioc);
+   test_hash_slot();
+   test_reconnect_policy();
+   test_timer_wheel();
+   test_resolve_cache();
+   test_literal_endpoint();
+   test_interleave_families();
+   test_happy_eyeballs();
+   test_latency_histogram();
+   test_stats();
+   test_diagnostics();
+   test_recording_stream(ioc);
+   test_fair_queue();
+   test_coalescing_policy();
+   test_submission_queue();
+   test_hub_sunsubscribe();
+   test_request_pool();
+   test_request_view();
+   test_command_table();
+   test_command_info_capture(ioc);
+
    ioc.run();
 }
 
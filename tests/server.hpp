@@ -0,0 +1,66 @@
+/* Copyright (c) 2018-2022 Marcelo Zimbres Silva (mzimbres@gmail.com)
+ *
+ * Distributed under the Boost Software License, Version 1.0. (See
+ * accompanying file LICENSE.txt)
+ */
+
+#include <string>
+#include <vector>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+
+/* Answers the commands read from the stream like Redis does, for
+ * tests of transports that the Redis server used by the tests doesn't
+ * listen on. Knows HELLO, PING and QUIT, whose arguments must not
+ * contain CRLF, and returns after answering QUIT or on error.
+ */
+template <class SyncReadWriteStream>
+void serve_redis(SyncReadWriteStream& stream)
+{
+   namespace net = boost::asio;
+
+   std::string buffer;
+   boost::system::error_code ec;
+
+   auto const read_line = [&]() {
+      auto const n = net::read_until(stream, net::dynamic_buffer(buffer), "\r\n", ec);
+      if (ec)
+         return std::string{};
+
+      auto line = buffer.substr(0, n - 2);
+      buffer.erase(0, n);
+      return line;
+   };
+
+   for (;;) {
+      auto const header = read_line();
+      if (ec)
+         return;
+
+      std::vector<std::string> cmd;
+      auto const size = std::stoul(header.substr(1));
+      for (std::size_t i = 0; i < size && !ec; ++i) {
+         read_line();
+         cmd.push_back(read_line());
+      }
+
+      if (ec || cmd.empty())
+         return;
+
+      std::string resp;
+      if (cmd.front() == "HELLO") {
+         resp = "%1\r\n$6\r\nserver\r\n$5\r\nredis\r\n";
+      } else if (cmd.front() == "PING") {
+         resp = cmd.size() == 1 ? "+PONG\r\n" : "$" + std::to_string(cmd[1].size()) + "\r\n" + cmd[1] + "\r\n";
+      } else if (cmd.front() == "QUIT") {
+         resp = "+OK\r\n";
+      } else {
+         resp = "-ERR unknown command\r\n";
+      }
+
+      net::write(stream, net::buffer(resp), ec);
+      if (ec || cmd.front() == "QUIT")
+         return;
+   }
+}